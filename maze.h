@@ -2,126 +2,660 @@
 #define MAZE_H
 
 #include <SDL2/SDL.h>
-#include <stdio.h>
-#include <math.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
+#include "maze_core.h"
 
-#define SCREEN_HEIGHT 768
-#define SCREEN_WIDTH 1024
+/* Render paths selectable at startup with -r */
+#define RENDER_LINES 0
+#define RENDER_SOFT 1
+#define RENDER_BATCH 2
 
-#define MAP_WIDTH 24
-#define MAP_HEIGHT 24
+/* Rectangle batches of the batched render path: the sky, the ground, and
+ * both shades of each of the 5 wall colors
+ */
+#define BATCH_SKY 0
+#define BATCH_GROUND 1
+#define BATCH_WALLS 2
+#define BATCH_GROUPS (BATCH_WALLS + 5 * 2)
+
+/* Screen columns handed to a worker thread at a time */
+#define COLUMN_GRAIN 16
+
+/* Ray kernels selectable with -k, and the width of a packet of rays */
+#define KERNEL_SCALAR 0
+#define KERNEL_SIMD 1
+#define KERNEL_FIXED 2
+#define KERNEL_SKIP 3
+#define PACKET_SIZE 4
+
+/* 16.16 fixed point of the fixed-point kernel and of texture rows */
+#define FIX_SHIFT 16
+#define FIX_ONE (1 << FIX_SHIFT)
+/* Grid delta of a ray parallel to the other axis: never reached */
+#define FIX_FAR ((int64_t)1 << 40)
+/* Mantissa bits indexing the reciprocal table */
+#define RECIP_BITS 11
+
+/* Loads of every level timed by the benchmark, the best one is reported */
+#define LOAD_RUNS 5
+
+/* Simulation ticks per second, whatever the frame rate, and how far behind
+ * the simulation may fall before the game slows down instead of catching up
+ */
+#define TICK_RATE 60
+#define TICK_NS (1e9 / TICK_RATE)
+#define MAX_LAG_TICKS 8
+
+/* Frame rate option value that leaves the frame rate to vsync */
+#define FPS_VSYNC -1
+
+/* Longest sleep of an idle game between two looks at the clock, in ms */
+#define IDLE_WAIT_MS 250
+
+/* Package energy counter of the CPU, read to report power when idle */
+#define ENERGY_FILE "/sys/class/powercap/intel-rapl:0/energy_uj"
+
+/* ARGB8888 colors of the software framebuffer */
+#define SKY_COLOR 0xFFFFB266
+#define GROUND_COLOR 0xFF593C1E
+
+/* Wall textures: TEX_SIZE texels a side, one per wall color (1-4 and any
+ * other wall), loaded from TEX_DIR
+ */
+#define TEX_SHIFT 6
+#define TEX_SIZE (1 << TEX_SHIFT)
+#define TEX_TYPES 5
+#define TEX_DIR "textures"
+/* Screen columns the software path draws at a time, 32 bytes of every row */
+#define STRIP_COLS 8
+/* Floor and ceiling rows handed to a worker thread at a time */
+#define ROW_GRAIN 16
+
+/* Nearest depth a sprite is drawn at, in cells: the player is standing on
+ * anything closer
+ */
+#define SPRITE_NEAR 0.25
+/* Words of a column of the sprite coverage mask, a bit per row */
+#define COVER_WORDS ((SCREEN_HEIGHT + 63) / 64)
+
+/* Bins of the ray cost histograms: bin b holds 2^(b-1) to 2^b - 1 steps */
+#define COST_BINS 24
+/* Cells across the heatmap of the overlay, and its pixels per cell */
+#define HEAT_CELLS 64
+#define HEAT_SCALE 3
+/* Shades of the heatmap and of the column cost bar */
+#define HEAT_SHADES 8
+/* Rectangle groups of the overlay: its background, the walls, the shades */
+#define COST_BACK 0
+#define COST_WALL 1
+#define COST_SHADES 2
+#define COST_GROUPS (COST_SHADES + HEAT_SHADES)
+/* Height in pixels of the column cost bar, for the costliest column */
+#define COST_BAR_HEIGHT 96
+
+/* Replay logs: their magic, the version of their layout */
+#define REPLAY_MAGIC "MAZEREC"
+#define REPLAY_VERSION 1
+/* Ticks at most in a run of a replay log, which takes a byte */
+#define REPLAY_RUN 16
 
 /**
  * struct SDL_Instance - Struct for SDL rendering in window
  * @window: The window to display rendering in
  * @renderer: The renderer to render graphics with
+ * @surface: Offscreen surface a headless benchmark renders into with a
+ * software renderer, NULL with a window
+ * @frame: Streaming texture the software framebuffer is uploaded to
+ * @cache: Render target the line path draws into, NULL if not supported;
+ * like @frame, it keeps the last frame to present it again
+ * @pixels: Software framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels
+ * @tex: Wall textures of the software render path
+ * @batch: Rectangle batches of the batched render path
+ * @stats: Draw calls and state changes issued so far
+ * @cost: The ray cost counters the overlay shows, NULL if not counted
+ * @mode: Render path in use (RENDER_LINES, RENDER_SOFT or RENDER_BATCH)
  **/
 typedef struct SDL_Instance
 {
 	SDL_Window *window;
 	SDL_Renderer *renderer;
+	SDL_Surface *surface;
+	SDL_Texture *frame;
+	SDL_Texture *cache;
+	Uint32 *pixels;
+	struct atlas *tex;
+	struct batch *batch;
+	struct draw_stats *stats;
+	struct ray_cost *cost;
+	int mode;
 } SDL_Instance;
 
 /**
- * struct double_s - Struct for x/y values of doubles
- * @x: X value of the object
- * @y: Y value of the object
+ * struct atlas - Wall, floor and ceiling textures, stored column-major
+ * @texels: Every wall texture, in both shades: texture 2 * type + side.
+ * Texel (u, v), column u and row v, is at u * TEX_SIZE + v, so a wall
+ * slice reads a single texture column front to back
+ * @floor: The floor texture; u runs along the map's x axis, v along y
+ * @ceiling: The ceiling texture, laid out as the floor
+ * @sprites: The sprite of every entity type, laid out as the walls;
+ * texels with a zero alpha are transparent
+ * @opaque: The first opaque texel row of every column of every sprite,
+ * and one past its last; both are 0 for a transparent column
  **/
-typedef struct double_s
+typedef struct atlas
 {
-	double x;
-	double y;
-} double_s;
+	Uint32 texels[TEX_TYPES * 2][TEX_SIZE * TEX_SIZE];
+	Uint32 floor[TEX_SIZE * TEX_SIZE];
+	Uint32 ceiling[TEX_SIZE * TEX_SIZE];
+	Uint32 sprites[ENTITY_TYPES][TEX_SIZE * TEX_SIZE];
+	Uint8 opaque[ENTITY_TYPES][TEX_SIZE][2];
+} atlas;
 
 /**
- * struct int_s - Struct for x/y values of ints
- * @x: X value of the object
- * @y: Y value of the object
+ * struct batch - The rectangles of a frame, grouped by color
+ * @rects: The rectangles of every group; a run of adjacent columns with
+ * the same slice is one rectangle
+ * @count: The number of rectangles in every group
  **/
-typedef struct int_s
+typedef struct batch
 {
-	int x;
-	int y;
-} int_s;
+	SDL_Rect rects[BATCH_GROUPS][SCREEN_WIDTH];
+	int count[BATCH_GROUPS];
+} batch;
 
 /**
- * struct keys - Struct to keep track of key presses
- * @up: Is up pressed (1) or not (0)
- * @down: Is down pressed (1) or not (0)
- * @right: Is right pressed (1) or not (0)
- * @left: Is left pressed (1) or not (0)
+ * struct draw_stats - Work handed to the renderer
+ * @frames: The number of frames drawn
+ * @calls: The number of draw calls (lines, rectangles, texture copies and
+ * uploads)
+ * @states: The number of render state changes (draw color, render target)
  **/
-typedef struct keys
+typedef struct draw_stats
 {
-	int up;
-	int down;
-	int right;
-	int left;
-} keys;
+	long frames;
+	long calls;
+	long states;
+} draw_stats;
 
 /**
  * struct level - Struct to contain the level and all starting values
  * @map: The map of the level
- * @height: height of that map
  * @win: The x/y coordinate of the win space
  * @play: The x/y starting position of the player
- * @dir: The x/y of the direction vector the player is looking
- * @plane: The x/y direction vector of the projection plane
+ * @angle: The view angle of the player, out of ANGLE_STEPS
  **/
 typedef struct level
 {
-	char **map;
-	size_t height;
+	grid *map;
 	int_s win;
 	double_s play;
+	int angle;
+} level;
+
+/**
+ * struct world - The levels of a game, loaded one ahead of the player
+ * @files: The level files, in the order they are played
+ * @count: The number of level files
+ * @current: The index of the level being played
+ * @stage: The level being played
+ * @next: The following level, once prefetched; its map is NULL if it
+ * could not be loaded or there is none
+ * @loader: The thread prefetching @next
+ * @loading: Whether @loader is running, or has not been joined yet
+ **/
+typedef struct world
+{
+	char **files;
+	int count;
+	int current;
+	level stage;
+	level next;
+	pthread_t loader;
+	int loading;
+} world;
+
+/**
+ * struct options - Command line options of the game
+ * @render: Render path to use (RENDER_LINES, RENDER_SOFT or RENDER_BATCH)
+ * @bench: Number of headless frames to render per level, 0 to play
+ * @threads: Number of threads casting rays, the main thread included
+ * @kernel: Ray kernel to cast with (KERNEL_SCALAR, KERNEL_SIMD, KERNEL_FIXED
+ * or KERNEL_SKIP)
+ * @verify: Check the kernel against the scalar one before benchmarking
+ * @fps: Frame rate cap, 0 for none, or FPS_VSYNC to follow the display
+ * @sim: Number of headless simulation ticks to run per level, 0 for none
+ * @cost: Count the DDA steps of the rays, per column, frame and cell
+ * @trace: Path, without suffix, of the trace files to write, or NULL not
+ * to trace
+ * @budget: Frame time budget of the trace, in ms
+ * @record: Path of the replay log to record the game to, or NULL
+ * @replay: Path of the replay log to replay, or NULL
+ * @window: Replay in the window rather than headless
+ **/
+typedef struct options
+{
+	int render;
+	int bench;
+	int threads;
+	int kernel;
+	int verify;
+	int fps;
+	int sim;
+	int cost;
+	char *trace;
+	double budget;
+	char *record;
+	char *replay;
+	int window;
+} options;
+
+/**
+ * struct idle_stats - What is on screen, and the time spent idle
+ * @drawn: The level and player pose of the frame on screen
+ * @valid: Whether a frame has been drawn yet
+ * @exposed: Whether the window needs the frame presented again
+ * @start: Time the game loop started, in nanoseconds
+ * @cpu: CPU time used by the game when the loop started, in nanoseconds
+ * @energy: CPU package energy counter when the loop started, in joules,
+ * or negative if it cannot be read
+ * @idle: Time spent idle, in nanoseconds
+ * @idle_cpu: CPU time used while idle, in nanoseconds
+ * @idle_energy: CPU package energy used while idle, in joules
+ **/
+typedef struct idle_stats
+{
+	level drawn;
+	int valid;
+	int exposed;
+	double start;
+	double cpu;
+	double energy;
+	double idle;
+	double idle_cpu;
+	double idle_energy;
+} idle_stats;
+
+/**
+ * struct sim_clock - Fixed timestep of the simulation
+ * @last: Time the clock was last read, in nanoseconds
+ * @lag: Time not simulated yet, in nanoseconds
+ * @prev_play: The player's position before the last tick
+ * @prev_angle: The player's view angle before the last tick
+ **/
+typedef struct sim_clock
+{
+	double last;
+	double lag;
+	double_s prev_play;
+	int prev_angle;
+} sim_clock;
+
+/**
+ * struct columns - Raycasting results of every screen column of a frame
+ * @dist: Perpendicular distance from the player to the wall hit
+ * @cell: The x/y map coordinates of the wall hit
+ * @side: The side of the wall hit, 0 for N/S and 1 for E/W
+ * @hit: Where along the wall face the ray hit, in [0, 1), left to right as
+ * seen by the player
+ * @play: The x/y position of the player the rays were cast from
+ * @angle: The view angle the rays were cast at
+ **/
+typedef struct columns
+{
+	double dist[SCREEN_WIDTH];
+	int_s cell[SCREEN_WIDTH];
+	int side[SCREEN_WIDTH];
+	double hit[SCREEN_WIDTH];
+	double_s play;
+	int angle;
+} columns;
+
+/**
+ * struct floor_job - Everything needed to cast the floor and ceiling rows
+ * @pixels: The framebuffer the rows are written into
+ * @tex: The floor and ceiling textures
+ * @play: The x/y position of the player
+ * @left: The x/y direction of the ray of the left edge of the screen
+ * @step: How much the ray direction changes from a column to the next
+ **/
+typedef struct floor_job
+{
+	Uint32 *pixels;
+	const atlas *tex;
+	double_s play;
+	double_s left;
+	double_s step;
+} floor_job;
+
+/**
+ * struct sprite_job - Everything needed to draw the sprites of a frame
+ * @pixels: The framebuffer the sprites are drawn into
+ * @tex: The sprite textures
+ * @ents: The entities, with the ones in view projected, nearest first
+ * @seen: The number of entities in view
+ * @cols: The rays of the frame, whose distances clip the sprites
+ **/
+typedef struct sprite_job
+{
+	Uint32 *pixels;
+	const atlas *tex;
+	const entities *ents;
+	int seen;
+	columns *cols;
+} sprite_job;
+
+/**
+ * struct fixed_cam - Camera of a frame in 16.16 fixed point
+ * @pos_x: The x position of the player, 64-bit so that positions past
+ * 32768 cells fit
+ * @pos_y: The y position of the player, likewise
+ * @dir_x: The x of the direction vector the player is looking
+ * @dir_y: The y of the direction vector the player is looking
+ * @plane_x: The x of the projection plane vector
+ * @plane_y: The y of the projection plane vector
+ **/
+typedef struct fixed_cam
+{
+	int64_t pos_x;
+	int64_t pos_y;
+	int32_t dir_x;
+	int32_t dir_y;
+	int32_t plane_x;
+	int32_t plane_y;
+} fixed_cam;
+
+/**
+ * struct kernel_diff - How far a ray kernel is from the scalar one
+ * @columns: The number of columns compared
+ * @cells: Columns whose hit cell or side differ
+ * @dists: Columns hitting the same cell and side at a different distance
+ * @max_err: Largest relative distance error on those columns
+ * @sum_err: Sum of the relative distance errors on those columns
+ **/
+typedef struct kernel_diff
+{
+	long columns;
+	long cells;
+	long dists;
+	double max_err;
+	double sum_err;
+} kernel_diff;
+
+/* Casts the packet of rays starting at a screen column of a frame */
+struct cast_job;
+typedef void (*packet_fn)(struct cast_job *, int);
+
+/**
+ * struct cast_job - Everything needed to cast the rays of a frame
+ * @kernel: The ray kernel to cast with
+ * @trace: The packet traversal picked for the running CPU
+ * @map: The map of the level
+ * @play: The x/y position of the player
+ * @dir: The x/y of the direction vector the player is looking
+ * @plane: The x/y direction vector of the projection plane
+ * @rays: The direction and grid deltas of the ray of every column
+ * @out: Where the results of every column are written
+ **/
+typedef struct cast_job
+{
+	int kernel;
+	packet_fn trace;
+	grid *map;
+	double_s play;
 	double_s dir;
 	double_s plane;
-} level;
+	const ray_table *rays;
+	columns *out;
+} cast_job;
+
+/**
+ * struct replay_header - Header of a replay log file
+ * @magic: REPLAY_MAGIC, NUL padded
+ * @version: REPLAY_VERSION
+ * @levels: The number of level files, whose paths follow the header, each
+ * as its length in an int32_t and its bytes
+ * @ticks: The number of ticks recorded
+ * @runs: The number of runs of ticks, which follow the paths
+ **/
+typedef struct replay_header
+{
+	char magic[8];
+	int32_t version;
+	int32_t levels;
+	int64_t ticks;
+	int64_t runs;
+} replay_header;
+
+/**
+ * struct replay_log - The keys held at every tick of a game
+ * @out: The log file being recorded, NULL for a log replayed
+ * @files: The level files played, in order
+ * @levels: The number of level files
+ * @runs: The runs of ticks, a byte each: the AGENT_* bits of the keys held
+ * in the low 4 bits, the number of ticks they were held less 1 in the high
+ * 4 bits
+ * @count: The number of runs, read or written
+ * @at: The run replayed next
+ * @left: The ticks of it left to replay
+ * @ticks: The number of ticks, recorded or in the log
+ * @held: The keys of the run being recorded, as AGENT_* bits
+ * @length: Its ticks, 0 before the first
+ * @failed: Set once a run could not be written; the log is then lost
+ **/
+typedef struct replay_log
+{
+	FILE *out;
+	char **files;
+	int levels;
+	uint8_t *runs;
+	int64_t count;
+	int64_t at;
+	int left;
+	int64_t ticks;
+	int held;
+	int length;
+	int failed;
+} replay_log;
+
+/**
+ * struct ray_cost - DDA steps of the rays cast, per column, frame and cell
+ * @column: The steps of the ray of every column of the last frame
+ * @frame: The steps of the last frame
+ * @total: The steps of every frame counted
+ * @frames: The number of frames counted
+ * @column_max: The most steps of a column so far
+ * @frame_max: The most steps of a frame so far
+ * @column_hist: The columns counted by steps, in COST_BINS power of 2 bins
+ * @frame_hist: The frames counted by steps, binned the same way
+ * @heat: The steps taken out of every cell of the level: a block of
+ * CHUNK_SIZE x CHUNK_SIZE counters per chunk of @map, laid out as its
+ * directory, NULL for a chunk no ray crossed
+ * @blocks: The number of entries of @heat
+ * @level: The index of the level counted, -1 before the first frame
+ * @map: Its grid
+ * @play: The position the last frame was cast from
+ * @hottest: The cell of the level the most steps were taken out of
+ * @heat_max: The steps taken out of it
+ * @rects: The rectangles of the overlay, in COST_GROUPS groups by color
+ * @count: The number of rectangles in every group
+ **/
+typedef struct ray_cost
+{
+	uint32_t column[SCREEN_WIDTH];
+	uint64_t frame;
+	uint64_t total;
+	long frames;
+	uint32_t column_max;
+	uint64_t frame_max;
+	long column_hist[COST_BINS];
+	long frame_hist[COST_BINS];
+	uint32_t **heat;
+	size_t blocks;
+	int level;
+	const grid *map;
+	double_s play;
+	int_s hottest;
+	uint32_t heat_max;
+	SDL_Rect rects[COST_GROUPS][HEAT_CELLS * HEAT_CELLS + SCREEN_WIDTH];
+	int count[COST_GROUPS];
+} ray_cost;
 
-/* Initialize SDL_Instance: init_instance.c */
-int init_instance(SDL_Instance *);
+/* Initialize SDL_Instance: init.c */
+int init_instance(SDL_Instance *, int, int);
+int init_frame(SDL_Instance *);
+void init_cache(SDL_Instance *);
+int init_offscreen(SDL_Instance *, int);
+
+/* Parse command line options: options.c */
+int parse_options(int, char **, options *);
+void print_usage(char *);
+const char *kernel_name(int);
+const char *render_name(int);
 
 /* Handle keyboard events: event_handlers.c */
-int keyboard_events(keys *);
+int keyboard_events(keys *, int *);
 void check_key_release_events(SDL_Event, keys *);
 int check_key_press_events(SDL_Event, keys *);
 
-/* Create the map for maze from file: create_maze.c */
-char **create_map(char *, double_s *, int_s *, size_t *);
-void plot_grid_points(char **, double_s *, int_s *, size_t, size_t, char *,
-		      int *);
-size_t get_line_count(char *);
-size_t get_char_count(char *);
-
-/* Build levels for every file passed to program: create_world.c */
-level *build_world_from_args(int, char **);
+/* Load the levels passed to the program, one ahead: maze_world.c */
+world *world_create(int, char **);
+void *prefetch_level(void *);
+void world_prefetch(world *);
+void world_sync(world *);
+int world_advance(world *);
+void world_free(world *);
 
-/* Draw the maze: draw.c */
-void draw(SDL_Instance, char **, double_s, double_s, double_s);
-void draw_walls(char **, double_s, SDL_Instance, double_s, double_s);
-void choose_color(SDL_Instance, char **, int_s, int);
+/* Draw the maze: draw_maze.c */
+void draw(SDL_Instance, worker_pool *, grid *, columns *);
+void draw_walls(grid *, columns *, SDL_Instance);
+void choose_color(SDL_Instance, grid *, int_s, int);
+Uint32 wall_color(char, int);
+int wall_type(char, int);
 void draw_background(SDL_Instance);
+int present_cached(SDL_Instance);
+void draw_report(SDL_Instance);
+
+/* Draw the maze in a few batches of rectangles: draw_batch.c */
+void draw_batch(SDL_Instance, grid *, columns *);
+void batch_frame(batch *, grid *, columns *);
+int wall_group(char, int);
+void batch_submit(SDL_Instance);
+
+/* Draw the maze into the software framebuffer: draw_soft.c */
+void draw_soft(SDL_Instance, worker_pool *, grid *, columns *);
+void draw_frame_soft(Uint32 *, const atlas *, worker_pool *, grid *,
+		     columns *);
+void draw_walls_soft(Uint32 *, const atlas *, grid *, columns *);
+void fill_walls(Uint32 *, const int *, const int *, const Uint32 *const *,
+		const Uint32 *, const Uint32 *);
+int wall_height(double);
+void wall_slice(double, int *, int *);
+
+/* Load the wall textures: textures.c */
+atlas *atlas_load(const char *);
+void texture_read(const char *, const char *, Uint32 *, Uint32, int);
+int texture_load(const char *, Uint32 *);
+void texture_generate(Uint32, int, Uint32 *);
+void texture_shade(const Uint32 *, Uint32 *);
+void sprite_read(const char *, const char *, Uint32 *, int);
+void sprite_generate(int, Uint32 *);
+void sprite_spans(const Uint32 *, Uint8 (*)[2]);
+
+/* Cast the textured floor and ceiling row by row: draw_floor.c */
+void cast_floor(worker_pool *, Uint32 *, const atlas *, columns *);
+void floor_range(void *, int, int);
+void floor_row(const floor_job *, int);
+
+/* Draw the entities as sprites clipped by the walls: draw_sprites.c */
+void draw_sprites(Uint32 *, const atlas *, worker_pool *, grid *,
+		  columns *);
+int sprite_view(entities *, columns *);
+int cmp_sprite(const void *, const void *);
+void sprite_range(void *, int, int);
+void sprite_draw(Uint32 *, const atlas *, const sprite *, columns *,
+		 uint64_t (*)[COVER_WORDS], int, int);
+
+/* Cast packets of adjacent rays on vector lanes: cast_packet.c */
+packet_fn pick_packet_trace(void);
+void packet_trace_base(cast_job *, int);
+void packet_trace_avx2(cast_job *, int);
+
+/* Cast rays in 16.16 fixed point: cast_fixed.c */
+void fixed_init(void);
+int64_t fixed_recip(int32_t);
+double fixed_column(grid *, fixed_cam *, int, int_s *, int *);
+void cast_fixed_range(cast_job *, int, int);
+
+/* Cast the rays of every column of a frame: cast_frame.c */
+void cast_frame(worker_pool *, int, grid *, double_s, int, ray_table *,
+		columns *);
+void cast_range(void *, int, int);
+void wall_hits(cast_job *, int, int);
+
+/* Headless benchmark of the renderer: bench.c */
+void script_keys(int, keys *);
+void bench_level(level *, worker_pool *, int, SDL_Instance *, int, double *,
+		 ray_cost *);
+double bench_load(char *);
+int run_bench(world *, options *);
+
+/* Fixed timestep simulation: sim_clock.c */
+void clock_reset(sim_clock *, level *);
+int clock_ticks(sim_clock *);
+void clock_tick(sim_clock *, level *, keys);
+int play_ticks(sim_clock *, world *, keys, int *, replay_log *);
+level clock_view(sim_clock *, level *);
+void cap_frame(double, int);
+int run_sim(world *, options *);
+
+/* Sleep while nothing moves, and report the cost of idling: idle.c */
+void idle_init(idle_stats *);
+int frame_unchanged(idle_stats *, level *, keys);
+void frame_drawn(idle_stats *, level *);
+void idle_wait(idle_stats *);
+double cpu_ns(void);
+double energy_joules(void);
+void idle_report(idle_stats *);
+
+/* Check a ray kernel against the scalar one: bench_verify.c */
+void compare_columns(columns *, columns *, kernel_diff *);
+int verify_kernel(level *, worker_pool *, int, int, kernel_diff *);
+int verify_level(level *, worker_pool *, int, int, int);
 
-/* Handle player movement/rotation: movement.c */
-void rotate(double_s *, double_s *, int);
-void movement(keys, double_s *, double_s *, double_s *, char **);
+/* Count the DDA steps of the rays: ray_cost.c */
+ray_cost *cost_create(void);
+int cost_level(ray_cost *, const grid *, int);
+void cost_frame(ray_cost *, const grid *, int, const ray_table *,
+		const columns *);
+void cost_walk(ray_cost *, const ray_table *, int);
+uint32_t cost_heat(const ray_cost *, int, int);
+int cost_bin(uint64_t);
+void cost_report(const ray_cost *);
+void cost_free(ray_cost *);
 
-/* Handle player winning: win.c */
-void print_win(void);
-int check_win(double_s, int_s, int *);
+/* Record the keys of a game and replay them: replay.c, replay_run.c */
+replay_log *replay_create(const char *, char **, int);
+void replay_record(replay_log *, keys);
+int replay_flush(replay_log *);
+int replay_save(replay_log *, const char *);
+replay_log *replay_load(const char *);
+int replay_read(replay_log *, const uint8_t *, size_t, const char *);
+int replay_next(replay_log *, keys *);
+void replay_free(replay_log *);
+int run_replay(world *, options *, replay_log *);
+int replay_frames(world *, options *, replay_log *, SDL_Instance *,
+		  worker_pool *, double *, long *);
+uint64_t replay_hash(const level *, int, const Uint32 *);
 
-/* Check distance from player to wall: dist_checks.c */
-double get_wall_dist(char **, double_s *, int_s *, int_s *, double_s *, int *,
-		     double_s *, double_s *);
-void check_ray_dir(int_s *, double_s *, double_s, int_s, double_s, double_s);
+/* Draw the ray cost overlay: draw_cost.c */
+int cost_toggle(void);
+void cost_overlay(SDL_Instance);
+void cost_heatmap(ray_cost *);
+void cost_bars(ray_cost *);
+Uint32 cost_shade(int);
 
-/* Free and close everything necessary: free_stuff.c */
-void free_memory(SDL_Instance, char **, size_t);
-void free_map(char **, size_t);
+/* Free and close everything necessary: free.c */
+void free_memory(SDL_Instance, grid *);
+void free_map(grid *);
 void close_SDL(SDL_Instance);
+void close_offscreen(SDL_Instance);
 #endif
@@ -0,0 +1,904 @@
+#ifndef MAZE_CORE_H
+#define MAZE_CORE_H
+
+/* The maze, its levels and tools, shared with the programs built without
+ * SDL: the level compiler, checker and generator, and the agent library
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <dirent.h>
+#include <limits.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define SCREEN_HEIGHT 768
+#define SCREEN_WIDTH 1024
+
+/* Cells per side of a map chunk, and chunks kept loaded on every side of
+ * the one the player is in
+ */
+#define CHUNK_SHIFT 6
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define RESIDENT_RADIUS 4
+/* Chunks loaded at most: the area is only trimmed one chunk further out */
+#define RESIDENT_MAX ((2 * RESIDENT_RADIUS + 3) * (2 * RESIDENT_RADIUS + 3))
+
+/* Rows and columns a level may have, so cell and chunk indices fit an int */
+#define MAP_MAX (1 << 24)
+
+/* Wall type of the cells outside the map and of the chunks not loaded */
+#define SENTINEL_WALL '#'
+
+/* Smallest empty box radius the skip kernel jumps across */
+#define SKIP_MIN 2
+/* Grid delta of a ray parallel to the other axis, instead of inf */
+#define DELTA_FAR 1e30
+
+/* View angles per full turn, angles turned per frame (about 0.03 rad) */
+#define ANGLE_STEPS 4096
+#define ROTATE_STEP 20
+/* Cells the player moves per tick, forward or back */
+#define MOVE_SPEED 0.07
+/* Length of the projection plane, relative to the view direction */
+#define VIEW_PLANE 0.5
+
+/* Compiled levels: file signature, format version and file name suffix */
+#define LEVEL_MAGIC "MAZEC\r\n\032"
+#define LEVEL_VERSION 2
+#define LEVEL_SUFFIX ".mazec"
+/* Seed of the level file checksums, and alignment of the chunk array */
+#define LEVEL_SEED 0xcbf29ce484222325ULL
+#define LEVEL_ALIGN 4096
+/* Bytes of an entity in a compiled level: its row, column and type */
+#define ENTITY_BYTES (2 * sizeof(double) + 1)
+
+/* View angle of a level that does not set one: looking towards -x */
+#define START_ANGLE (ANGLE_STEPS / 2)
+
+/* Traced scopes: the frame, and the parts of it */
+#define TRACE_FRAME 0
+#define TRACE_INPUT 1
+#define TRACE_TICKS 2
+#define TRACE_MOVE 3
+#define TRACE_CAST 4
+#define TRACE_DRAW 5
+#define TRACE_BACKGROUND 6
+#define TRACE_WALLS 7
+#define TRACE_FLOOR 8
+#define TRACE_SPRITES 9
+#define TRACE_UPLOAD 10
+#define TRACE_PRESENT 11
+#define TRACE_TASK 12
+#define TRACE_NAMES 13
+/* Events kept per thread, the last ones, and threads traced at most */
+#define TRACE_EVENTS (1 << 16)
+#define TRACE_THREADS 64
+/* Frame time budget of the trace, in ms, unless -B sets one: 60 fps */
+#define TRACE_BUDGET_MS (1000.0 / 60)
+
+/* Entity types, each drawn with its own sprite: the win marker, and the
+ * keys and enemies of 'k' and 'e' cells
+ */
+#define ENTITY_WIN 0
+#define ENTITY_KEY 1
+#define ENTITY_ENEMY 2
+#define ENTITY_TYPES 3
+
+/* Solvers of the level checker, run on every level */
+#define SOLVE_BFS 0
+#define SOLVE_ASTAR 1
+#define SOLVERS 2
+/* Path length returned when the win cell cannot be reached, or when the
+ * solver runs out of memory
+ */
+#define SOLVE_NO_PATH -1
+#define SOLVE_NO_MEMORY -2
+
+/* Actions of a simulated agent for a step, the keys it holds, as bits */
+#define AGENT_UP 1
+#define AGENT_DOWN 2
+#define AGENT_LEFT 4
+#define AGENT_RIGHT 8
+/* Agents stepped per task of the worker pool */
+#define AGENT_GRAIN 4096
+
+/* Observations of the agents: pixels across and down, a sixteenth of the
+ * screen each way, and bytes per pixel, one per channel
+ */
+#define OBS_WIDTH 64
+#define OBS_HEIGHT 48
+#define OBS_TYPE 0
+#define OBS_SIDE 1
+#define OBS_DEPTH 2
+#define OBS_CHANNELS 3
+/* Depth steps per cell, so depths up to 255 / 8 cells can be told apart */
+#define OBS_DEPTH_SCALE 8
+/* Wall type seen of the walls outside the map */
+#define OBS_SENTINEL 10
+/* Observations rendered per task of the worker pool */
+#define OBS_GRAIN 64
+
+/* Map cells across a run of walls of one type in generated mazes */
+#define GEN_WALL_SHIFT 4
+
+/* Frame time the benchmark holds the 99th percentile to: 60 fps */
+#define FRAME_BUDGET_NS (1e9 / 60)
+
+/**
+ * struct double_s - Struct for x/y values of doubles
+ * @x: X value of the object
+ * @y: Y value of the object
+ **/
+typedef struct double_s
+{
+	double x;
+	double y;
+} double_s;
+
+/**
+ * struct int_s - Struct for x/y values of ints
+ * @x: X value of the object
+ * @y: Y value of the object
+ **/
+typedef struct int_s
+{
+	int x;
+	int y;
+} int_s;
+
+/**
+ * struct keys - Struct to keep track of key presses
+ * @up: Is up pressed (1) or not (0)
+ * @down: Is down pressed (1) or not (0)
+ * @right: Is right pressed (1) or not (0)
+ * @left: Is left pressed (1) or not (0)
+ **/
+typedef struct keys
+{
+	int up;
+	int down;
+	int right;
+	int left;
+} keys;
+
+/**
+ * struct chunk - CHUNK_SIZE x CHUNK_SIZE cells of a map
+ * @solid: Solidity bitmap, one word per row, bit y set for a wall in column y
+ * @cells: Wall-type bytes, row-major
+ * @field: Chebyshev distance of every cell to the nearest wall, counting
+ * everything outside the chunk as walls, capped at 255 (0 for walls)
+ * @cx: The chunk row of the chunk in the map
+ * @cy: The chunk column of the chunk in the map
+ **/
+typedef struct chunk
+{
+	uint64_t solid[CHUNK_SIZE];
+	char cells[CHUNK_SIZE * CHUNK_SIZE];
+	uint8_t field[CHUNK_SIZE * CHUNK_SIZE];
+	int cx;
+	int cy;
+} chunk;
+
+/**
+ * struct sprite - An entity in view, projected onto the screen
+ * @depth: Its distance from the player along the view direction
+ * @center: The screen column of its center
+ * @width: Its width on screen, in columns
+ * @height: Its height on screen, in rows
+ * @type: Its entity type
+ **/
+typedef struct sprite
+{
+	double depth;
+	int center;
+	int width;
+	int height;
+	int type;
+} sprite;
+
+/**
+ * struct entities - The entities of a level, as a structure of arrays
+ * @x: The row of every entity, at the center of its cell
+ * @y: The column of every entity, at the center of its cell
+ * @type: The entity type of every entity
+ * @count: The number of entities
+ * @cap: The number of entities the arrays have room for
+ * @seen: The entities in view in the frame being drawn, nearest first;
+ * room for @cap of them
+ **/
+typedef struct entities
+{
+	double *x;
+	double *y;
+	unsigned char *type;
+	int count;
+	int cap;
+	sprite *seen;
+} entities;
+
+/**
+ * struct row_span - Where a row of the map is in its level file
+ * @start: Offset of the first cell of the row
+ * @len: Number of cells of the row, line ending excluded
+ **/
+typedef struct row_span
+{
+	size_t start;
+	int len;
+} row_span;
+
+/**
+ * struct level_text - A level file being parsed
+ * @file: The path of the file, for error messages
+ * @text: The file, mapped in memory
+ * @size: The size of the file in bytes
+ * @rows: The row index built so far
+ * @cap: The number of rows @rows has room for
+ * @ents: The entities found so far
+ * @height: The number of rows parsed so far
+ * @width: The length of the longest row so far
+ * @found_play: Whether the player start has been seen
+ * @found_win: Whether the win square has been seen
+ **/
+typedef struct level_text
+{
+	const char *file;
+	const char *text;
+	size_t size;
+	row_span *rows;
+	int cap;
+	entities *ents;
+	int height;
+	int width;
+	int found_play;
+	int found_win;
+} level_text;
+
+/**
+ * struct level_header - Start of a compiled level file
+ * @magic: LEVEL_MAGIC, without its terminating null byte
+ * @version: LEVEL_VERSION of the program that compiled the level
+ * @chunk_bytes: The size of a chunk, so other layouts are rejected
+ * @width: The number of columns of the map
+ * @height: The number of rows of the map
+ * @chunk_rows: The number of rows of chunks
+ * @chunk_cols: The number of columns of chunks
+ * @angle: The player's start view angle
+ * @win_x: The row of the win square
+ * @win_y: The column of the win square
+ * @entities: The number of entities, win marker included
+ * @play_x: The player's start row
+ * @play_y: The player's start column
+ * @chunks_at: Offset of the chunks in the file, a multiple of LEVEL_ALIGN
+ * @checksum: Checksum of the header, with this field zero, and of the
+ * table of chunk checksums that follows it
+ *
+ * Description: The header is followed by one checksum per chunk, then by
+ * the chunks themselves, stored exactly as they are in memory (distance
+ * field included) so the game can use them in place, then by the rows,
+ * the columns and the types of the entities, ENTITY_BYTES per entity.
+ **/
+typedef struct level_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t chunk_bytes;
+	int32_t width;
+	int32_t height;
+	int32_t chunk_rows;
+	int32_t chunk_cols;
+	int32_t angle;
+	int32_t win_x;
+	int32_t win_y;
+	int32_t entities;
+	double play_x;
+	double play_y;
+	uint64_t chunks_at;
+	uint64_t checksum;
+} level_header;
+
+/**
+ * struct grid - Map of a level, stored in chunks loaded around the player
+ * @dir: Chunk directory, row-major, with a ring of chunks around the map;
+ * every entry not loaded points to @horizon
+ * @horizon: Shared chunk of walls standing in for every chunk not loaded
+ * @resident: The loaded chunks
+ * @count: The number of loaded chunks
+ * @spare: Evicted chunks kept for reuse
+ * @spares: The number of spare chunks
+ * @width: The number of columns of the map (its longest row)
+ * @height: The number of rows of the map
+ * @dir_stride: The number of entries in a row of @dir
+ * @center: The chunk the loaded area was last centered on
+ * @text: The level file, mapped in memory; chunks are loaded from it
+ * @size: The size of the level file in bytes
+ * @rows: Where every row is in @text, for a text level
+ * @chunks: The chunks of a compiled level, row-major, in @text
+ * @sums: The checksum of every chunk of a compiled level, in @text
+ * @ents: The keys, enemies and win marker of the level
+ **/
+typedef struct grid
+{
+	chunk **dir;
+	chunk *horizon;
+	chunk **resident;
+	int count;
+	chunk **spare;
+	int spares;
+	int width;
+	int height;
+	int dir_stride;
+	int_s center;
+	const char *text;
+	size_t size;
+	row_span *rows;
+	const chunk *chunks;
+	const uint64_t *sums;
+	entities *ents;
+} grid;
+
+/**
+ * grid_chunk - Chunk holding a map cell.
+ * @map: The grid.
+ * @x: The row of the cell, from -CHUNK_SIZE to height + CHUNK_SIZE - 1.
+ * @y: The column of the cell, from -CHUNK_SIZE to width + CHUNK_SIZE - 1.
+ *
+ * Return: The chunk, or the horizon chunk if it is not loaded. The shifts
+ * round negative coordinates down, into the ring around the map.
+ **/
+static inline const chunk *grid_chunk(const grid *map, int x, int y)
+{
+	return (map->dir[((x >> CHUNK_SHIFT) + 1) * map->dir_stride +
+			 (y >> CHUNK_SHIFT) + 1]);
+}
+
+/**
+ * grid_solid - Whether a map cell is a wall.
+ * @map: The grid.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: 1 for a wall (cells outside the map or not loaded included), 0
+ * for an empty cell.
+ **/
+static inline int grid_solid(const grid *map, int x, int y)
+{
+	return ((grid_chunk(map, x, y)->solid[x & (CHUNK_SIZE - 1)] >>
+		 (y & (CHUNK_SIZE - 1))) & 1);
+}
+
+/**
+ * grid_cell - Wall type of a map cell.
+ * @map: The grid.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: The map character of the cell.
+ **/
+static inline char grid_cell(const grid *map, int x, int y)
+{
+	return (grid_chunk(map, x, y)->cells[(x & (CHUNK_SIZE - 1)) *
+					     CHUNK_SIZE +
+					     (y & (CHUNK_SIZE - 1))]);
+}
+
+/**
+ * grid_field - Distance of a map cell to the nearest wall.
+ * @map: The grid.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: The distance field of the cell, 0 for a wall.
+ **/
+static inline int grid_field(const grid *map, int x, int y)
+{
+	return (grid_chunk(map, x, y)->field[(x & (CHUNK_SIZE - 1)) *
+					     CHUNK_SIZE +
+					     (y & (CHUNK_SIZE - 1))]);
+}
+
+/**
+ * struct ray_state - Starting state of the ray of one screen column
+ * @dir: The x/y direction of the ray
+ * @delta: The distance along the ray between two x/y grid lines
+ * @side: The distance along the ray to the first x/y grid line
+ * @cell: The map cell the ray starts in
+ * @step: The x/y step direction of the ray (-1 or 1)
+ **/
+typedef struct ray_state
+{
+	double_s dir;
+	double_s delta;
+	double_s side;
+	int_s cell;
+	int_s step;
+} ray_state;
+
+/**
+ * struct ray_table - Rays of every screen column for one view angle
+ * @angle: The view angle the table holds, -1 before the first fill
+ * @dir_x: The x direction of the ray of every column
+ * @dir_y: The y direction of the ray of every column
+ * @del_x: The distance along every ray between two x grid lines
+ * @del_y: The distance along every ray between two y grid lines
+ **/
+typedef struct ray_table
+{
+	int angle;
+	double dir_x[SCREEN_WIDTH];
+	double dir_y[SCREEN_WIDTH];
+	double del_x[SCREEN_WIDTH];
+	double del_y[SCREEN_WIDTH];
+} ray_table;
+
+/**
+ * struct solve_grid - The whole map of a level as one bitset, for solving
+ * @open: Bit c % 64 of word c / 64 is set when cell c is empty, where
+ * cell (x, y) is c = (x + 1) * 64 * @words + y: rows of 64 * @words cells,
+ * with a row of walls above and below the map
+ * @words: The number of words of a row
+ * @rows: The number of rows, those two included
+ **/
+typedef struct solve_grid
+{
+	uint64_t *open;
+	size_t words;
+	int rows;
+} solve_grid;
+
+/**
+ * solve_solid - Whether a cell of a solve_grid is a wall.
+ * @sg: The map.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: 1 for a wall, cells outside the map included, 0 for an empty
+ * cell.
+ **/
+static inline int solve_solid(const solve_grid *sg, int x, int y)
+{
+	size_t c;
+
+	if (x < -1 || x > sg->rows - 2 || y < 0 || y >= (int)sg->words * 64)
+		return (1);
+	c = (size_t)(x + 1) * sg->words * 64 + y;
+	return (!((sg->open[c >> 6] >> (c & 63)) & 1));
+}
+
+/**
+ * struct solve_node - A cell waiting in the A* open list
+ * @f: The length of the path through it, as estimated
+ * @h: The estimated length of the rest of the path
+ * @cell: The cell, numbered as in solve_grid
+ **/
+typedef struct solve_node
+{
+	uint32_t f;
+	uint32_t h;
+	size_t cell;
+} solve_node;
+
+/**
+ * struct solve_heap - The A* open list, a binary min-heap on f, then h
+ * @nodes: The nodes
+ * @count: The number of nodes
+ * @cap: The number of nodes @nodes has room for
+ **/
+typedef struct solve_heap
+{
+	solve_node *nodes;
+	size_t count;
+	size_t cap;
+} solve_heap;
+
+/**
+ * struct solve_result - What checking a level found
+ * @file: The path of the level file
+ * @loaded: Whether the level could be loaded
+ * @width: The number of columns of the map
+ * @height: The number of rows of the map
+ * @play: The player's start cell
+ * @win: The win cell
+ * @steps: The length of the shortest path found by every solver, in moves
+ * between adjacent cells, or SOLVE_NO_PATH or SOLVE_NO_MEMORY
+ * @visited: The number of cells every solver visited
+ * @ns: The time every solver took, in nanoseconds
+ * @load_ns: The time loading the level and its bitset took, in nanoseconds
+ **/
+typedef struct solve_result
+{
+	char *file;
+	int loaded;
+	int width;
+	int height;
+	int_s play;
+	int_s win;
+	long steps[SOLVERS];
+	long visited[SOLVERS];
+	double ns[SOLVERS];
+	double load_ns;
+} solve_result;
+
+/**
+ * struct maze_gen - A maze generated a map row at a time (Eller's algorithm)
+ * @width: The number of columns of the map, odd
+ * @height: The number of rows of the map, odd
+ * @cells: The number of maze cells across, (@width - 1) / 2: the map has a
+ * wall between every two of them and all around them
+ * @row: The number of map rows written so far
+ * @state: The state of the random number generator
+ * @bits: Random bits not used yet
+ * @nbits: The number of them
+ * @set: The label of the set of each cell of the current maze row, below
+ * @cells; cells of the same set are already joined by a path
+ * @parent: The union-find parent of each label
+ * @count: The cells of each set not yet visited by the pass down
+ * @linked: Whether a cell of each set opens down to the next row
+ * @down: Whether each cell of the current row opens down
+ *
+ * Description: Only the current maze row is kept, so the memory taken
+ * depends on the width of the map and not on its height.
+ **/
+typedef struct maze_gen
+{
+	int width;
+	int height;
+	int cells;
+	int row;
+	uint64_t state;
+	uint64_t bits;
+	int nbits;
+	int *set;
+	int *parent;
+	int *count;
+	unsigned char *linked;
+	unsigned char *down;
+} maze_gen;
+
+/**
+ * struct sim_level - A level the agents of a simulation play
+ * @open: The whole map, a bit per cell
+ * @cells: The map character of every cell, at the same index as its bit
+ * in @open, for the observations
+ * @play: The start position of its agents
+ * @win: The win square
+ * @angle: The start view angle of its agents
+ **/
+typedef struct sim_level
+{
+	solve_grid open;
+	char *cells;
+	double_s play;
+	int_s win;
+	int angle;
+} sim_level;
+
+/**
+ * struct agent_sim - Many agents playing levels at once, for training and
+ * evaluating navigation agents; an array per field
+ * @levels: The levels played
+ * @level_count: The number of levels
+ * @count: The number of agents
+ * @level: The level each agent plays
+ * @x: The row each agent is at
+ * @y: The column each agent is at
+ * @angle: The view angle of each agent, out of ANGLE_STEPS
+ * @dir_x: The x of the view direction of each agent
+ * @dir_y: The y of the view direction of each agent
+ * @plane_x: The x of the projection plane of each agent
+ * @plane_y: The y of the projection plane of each agent
+ * @done: Whether each agent has reached its win square; it is not moved
+ * again until reset
+ **/
+typedef struct agent_sim
+{
+	sim_level *levels;
+	int level_count;
+	int count;
+	int *level;
+	double *x;
+	double *y;
+	int *angle;
+	double *dir_x;
+	double *dir_y;
+	double *plane_x;
+	double *plane_y;
+	unsigned char *done;
+} agent_sim;
+
+/**
+ * struct sim_job - A step of every agent, shared out over the worker pool
+ * @sim: The simulation
+ * @actions: The AGENT_* bits of each agent for the step
+ * @won: The number of agents that reached their win square in the step
+ **/
+typedef struct sim_job
+{
+	agent_sim *sim;
+	const unsigned char *actions;
+	atomic_int won;
+} sim_job;
+
+/**
+ * struct obs_job - The observations of every agent, shared out over the
+ * worker pool
+ * @sim: The simulation, with the pose of every agent
+ * @out: The observations, OBS_HEIGHT x OBS_WIDTH x OBS_CHANNELS bytes per
+ * agent, in the order of the agents
+ * @rows: The distance of the floor or ceiling seen on each row
+ * @floor: The pixel of the floor or ceiling of each row, the same in every
+ * column
+ **/
+typedef struct obs_job
+{
+	const agent_sim *sim;
+	uint8_t *out;
+	double rows[OBS_HEIGHT];
+	uint8_t floor[OBS_HEIGHT][OBS_CHANNELS];
+} obs_job;
+
+/**
+ * struct trace_event - A traced scope that has ended
+ * @start: The time stamp counter when the scope started
+ * @end: The time stamp counter when the scope ended
+ * @name: The scope, a TRACE_* name
+ * @frame: The frame it was part of
+ **/
+typedef struct trace_event
+{
+	uint64_t start;
+	uint64_t end;
+	uint32_t name;
+	uint32_t frame;
+} trace_event;
+
+/**
+ * struct trace_ring - The last TRACE_EVENTS events of a thread
+ * @events: The events, event n at n % TRACE_EVENTS
+ * @head: The number of events recorded; only the thread writes them
+ **/
+typedef struct trace_ring
+{
+	trace_event events[TRACE_EVENTS];
+	atomic_ulong head;
+} trace_ring;
+
+/**
+ * struct trace_state - Everything traced since trace_start
+ * @prefix: The path of the trace files, without suffix
+ * @budget: The frame time budget, in time stamp counter ticks
+ * @ns_per_tick: Nanoseconds per tick of the time stamp counter
+ * @tsc0: The time stamp counter when tracing started
+ * @ns0: now_ns when tracing started
+ * @frame: The frame being drawn
+ * @present: The ticks the frame being drawn spent presenting, waiting for
+ * the display under vsync; they are not held to the budget
+ * @slow: The number of frames over budget
+ * @threads: The number of threads that recorded an event
+ * @rings: The ring of each of them, the thread that started tracing first
+ **/
+typedef struct trace_state
+{
+	const char *prefix;
+	uint64_t budget;
+	double ns_per_tick;
+	uint64_t tsc0;
+	double ns0;
+	atomic_uint frame;
+	uint64_t present;
+	int slow;
+	atomic_int threads;
+	trace_ring *rings[TRACE_THREADS];
+} trace_state;
+
+/* Function run by the worker pool on a [from, to) range of items */
+typedef void (*pool_fn)(void *, int, int);
+
+/**
+ * struct worker_pool - Persistent pool of threads sharing range jobs
+ * @threads: The worker threads, not counting the thread calling pool_run
+ * @count: The number of worker threads
+ * @lock: Protects the job description and the counters below
+ * @wake: Signaled when a new job is published or the pool shuts down
+ * @idle: Signaled when the last worker is done with the current job
+ * @generation: Incremented for every job, so workers notice new ones
+ * @running: Number of workers still busy with the current job
+ * @quit: Set to make the workers exit
+ * @fn: The function of the current job
+ * @ctx: The context of the current job
+ * @items: The number of items of the current job
+ * @grain: The number of items claimed at a time
+ * @next: The first item not claimed by any thread yet
+ **/
+typedef struct worker_pool
+{
+	pthread_t *threads;
+	int count;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	unsigned long generation;
+	int running;
+	int quit;
+	pool_fn fn;
+	void *ctx;
+	int items;
+	int grain;
+	atomic_int next;
+} worker_pool;
+
+/* Create the map for maze from file: create_maze.c */
+grid *create_map(char *, double_s *, int_s *, int *);
+grid *text_map(level_text *, double_s *, int_s *);
+int parse_level(level_text *, double_s *, int_s *);
+int parse_row(level_text *, size_t, size_t, double_s *, int_s *);
+int row_entities(level_text *, const char *, size_t);
+void level_error(level_text *, int, size_t, const char *, ...)
+	__attribute__((format(printf, 4, 5)));
+void plot_grid_points(double_s *, int_s *, size_t, size_t, const char *,
+		      int *);
+
+/* Map storage in chunks loaded around the player: grid.c */
+grid *grid_create(int, int);
+int chunk_load(grid *, int, int);
+void chunk_fill(chunk *, const char *const *, const int *);
+void chunk_install(grid *, chunk *, int, int);
+void chunk_evict(grid *, int);
+int chunk_mapped(grid *, chunk *);
+void chunk_field(chunk *);
+int grid_load_around(grid *, double_s);
+void grid_free(grid *);
+
+/* Compiled level files, used in place: level_file.c */
+uint64_t level_checksum(const void *, size_t, uint64_t);
+grid *compiled_map(level_text *, double_s *, int_s *, int *);
+int check_header(level_text *, const level_header *);
+int compiled_entities(level_text *, const level_header *);
+int chunk_map(grid *, int, int);
+int compile_level(char *, char *);
+
+/* Entities of a level, stored as a structure of arrays: entities.c */
+entities *entities_create(void);
+int entity_add(entities *, double, double, int);
+void entities_free(entities *);
+
+/* Handle player movement/rotation: movement.c */
+void rotate(int *, int);
+void movement(keys, int *, double_s *, grid *);
+
+/* Tables of view angles and of the rays of a view: view_table.c */
+void view_init(void);
+void view_vectors(int, double_s *, double_s *);
+void view_rays(ray_table *, int);
+
+/* Handle player winning: win.c */
+void print_win(void);
+int check_win(double_s, int_s, int *);
+
+/* Check distance from player to wall: dist_checks.c */
+double get_wall_dist(grid *, double_s *, int_s *, int_s *, double_s *, int *,
+		     double_s *, double_s *);
+void check_ray_dir(int_s *, double_s *, double_s, int_s, double_s, double_s);
+double cast_column(grid *, double_s, const ray_table *, int, int_s *, int *);
+void ray_setup(double_s, const ray_table *, int, ray_state *);
+double wall_distance(int_s, int_s, int, double_s, double_s);
+double skip_wall_dist(grid *, const ray_state *, double_s, int_s *, int *);
+double skip_column(grid *, double_s, const ray_table *, int, int_s *, int *);
+
+/* Persistent pool of worker threads: worker_pool.c */
+worker_pool *pool_create(int);
+void pool_destroy(worker_pool *);
+void pool_run(worker_pool *, pool_fn, void *, int, int);
+void pool_work(worker_pool *);
+void *worker_main(void *);
+
+/* Check that levels can be solved, and how: solve.c */
+int solve_grid_load(grid *, solve_grid *);
+long solve_bfs(const solve_grid *, int_s, int_s, long *);
+long solve_astar(const solve_grid *, int_s, int_s, long *);
+int heap_push(solve_heap *, solve_node);
+solve_node heap_pop(solve_heap *);
+void solve_level(solve_result *);
+void solve_range(void *, int, int);
+int solve_report(const solve_result *);
+char **level_list(char **, int, int *);
+void level_list_free(char **, int);
+
+/* Stream mazes of any height, a row at a time: generate.c */
+maze_gen *gen_create(int, int, uint64_t);
+int gen_bit(maze_gen *);
+int gen_next(maze_gen *, char *);
+void gen_join(maze_gen *, char *);
+void gen_split(maze_gen *, char *);
+int gen_write_text(maze_gen *, FILE *);
+int gen_band(const level_header *, const char *, int, int, uint64_t *,
+	     FILE *);
+int gen_write_level(maze_gen *, FILE *);
+void gen_free(maze_gen *);
+
+/* Step many agents at once, without SDL: agents.c */
+agent_sim *sim_create(char **, int, int);
+int sim_level_load(sim_level *, char *);
+void sim_reset(agent_sim *, int);
+int sim_step(agent_sim *, worker_pool *, const unsigned char *);
+void sim_range(void *, int, int);
+void sim_free(agent_sim *);
+
+/* Render what many agents see, without SDL: observe.c */
+int obs_cells_load(grid *, sim_level *);
+void obs_render(const agent_sim *, worker_pool *, uint8_t *);
+void obs_range(void *, int, int);
+void obs_view(const obs_job *, int);
+
+/* Time frames and report their statistics: bench_report.c */
+double now_ns(void);
+int cmp_double(const void *, const void *);
+void report_bench(double *, int);
+
+/* Trace the hot path of every frame: trace.c */
+extern int trace_enabled;
+const char *trace_scope_name(int);
+trace_ring *trace_ring_get(void);
+int trace_start(const char *, double);
+void trace_record(int, uint64_t, uint64_t);
+uint64_t trace_frame_begin(void);
+void trace_frame_end(uint64_t);
+int trace_over(uint64_t, uint64_t);
+void trace_slow_frame(uint64_t, uint64_t);
+int trace_dump(void);
+void trace_json(FILE *);
+void trace_csv(FILE *);
+void trace_stop(void);
+
+/**
+ * trace_clock - Read the time stamp counter.
+ *
+ * Return: The counter, or the time in ns where there is none.
+ **/
+static inline uint64_t trace_clock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#else
+	return ((uint64_t)now_ns());
+#endif
+}
+
+/**
+ * trace_begin - Start a traced scope.
+ *
+ * Return: The time it started, to pass to trace_end, or 0 when tracing is
+ * off, which costs this test only.
+ **/
+static inline uint64_t trace_begin(void)
+{
+	return (trace_enabled ? trace_clock() : 0);
+}
+
+/**
+ * trace_end - End a traced scope.
+ * @name: The scope, a TRACE_* name.
+ * @start: What trace_begin returned.
+ **/
+static inline void trace_end(int name, uint64_t start)
+{
+	if (trace_enabled)
+		trace_record(name, start, trace_clock());
+}
+#endif
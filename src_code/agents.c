@@ -0,0 +1,214 @@
+#include "../maze_core.h"
+
+/**
+ * sim_create - Load levels and put agents at their start.
+ * @files: The level files, text or compiled.
+ * @levels: The number of levels.
+ * @count: The number of agents; agent i plays level i % @levels.
+ *
+ * Return: The simulation, or NULL if a level cannot be loaded or memory
+ * runs out; the error has been reported.
+ *
+ * Description: The whole map of each level is kept (sim_level_load), so
+ * the agents can be anywhere in it, and the grid of the level is freed.
+ **/
+agent_sim *sim_create(char **files, int levels, int count)
+{
+	agent_sim *sim = calloc(1, sizeof(agent_sim));
+	int i;
+
+	if (sim == NULL || levels < 1 || count < 1)
+	{
+		free(sim);
+		return (NULL);
+	}
+	sim->levels = calloc(levels, sizeof(sim_level));
+	sim->level = malloc(sizeof(int) * count);
+	sim->x = malloc(sizeof(double) * count);
+	sim->y = malloc(sizeof(double) * count);
+	sim->angle = malloc(sizeof(int) * count);
+	sim->dir_x = malloc(sizeof(double) * count);
+	sim->dir_y = malloc(sizeof(double) * count);
+	sim->plane_x = malloc(sizeof(double) * count);
+	sim->plane_y = malloc(sizeof(double) * count);
+	sim->done = malloc(count);
+	if (sim->levels == NULL || sim->level == NULL || sim->x == NULL ||
+	    sim->y == NULL || sim->angle == NULL || sim->dir_x == NULL ||
+	    sim->dir_y == NULL || sim->plane_x == NULL || sim->plane_y == NULL ||
+	    sim->done == NULL)
+	{
+		fprintf(stderr, "agents: out of memory\n");
+		sim_free(sim);
+		return (NULL);
+	}
+	for (; sim->level_count < levels; sim->level_count++)
+		if (sim_level_load(&sim->levels[sim->level_count],
+				   files[sim->level_count]) != 0)
+		{
+			sim_free(sim);
+			return (NULL);
+		}
+	sim->count = count;
+	for (i = 0; i < count; i++)
+	{
+		sim->level[i] = i % levels;
+		sim_reset(sim, i);
+	}
+	return (sim);
+}
+
+/**
+ * sim_level_load - Load a level for the agents.
+ * @lv: Output for the level.
+ * @file: The level file.
+ *
+ * Return: 0 on success, 1 on failure; the error has been reported.
+ *
+ * Description: The map is kept twice: a bit per cell for moving, and a
+ * byte per cell, the wall types, for the observations.
+ **/
+int sim_level_load(sim_level *lv, char *file)
+{
+	grid *map;
+	int failed;
+
+	map = create_map(file, &lv->play, &lv->win, &lv->angle);
+	if (map == NULL)
+		return (1);
+	failed = solve_grid_load(map, &lv->open) ||
+		obs_cells_load(map, lv);
+	grid_free(map);
+	if (failed)
+	{
+		fprintf(stderr, "%s: out of memory\n", file);
+		free(lv->open.open);
+		free(lv->cells);
+	}
+	return (failed);
+}
+
+/**
+ * sim_reset - Put an agent back at the start of its level.
+ * @sim: The simulation.
+ * @i: The agent.
+ **/
+void sim_reset(agent_sim *sim, int i)
+{
+	const sim_level *lv = &sim->levels[sim->level[i]];
+	double_s dir, plane;
+
+	sim->x[i] = lv->play.x;
+	sim->y[i] = lv->play.y;
+	sim->angle[i] = lv->angle;
+	view_vectors(lv->angle, &dir, &plane);
+	sim->dir_x[i] = dir.x;
+	sim->dir_y[i] = dir.y;
+	sim->plane_x[i] = plane.x;
+	sim->plane_y[i] = plane.y;
+	sim->done[i] = 0;
+}
+
+/**
+ * sim_step - Move every agent one tick.
+ * @sim: The simulation.
+ * @pool: The worker pool to spread the agents over, or NULL.
+ * @actions: The AGENT_* bits of each agent.
+ *
+ * Return: The number of agents that reached their win square.
+ *
+ * Description: A step is a tick of the game: each agent turns and moves as
+ * the player would with the same keys held, under the same rules.
+ **/
+int sim_step(agent_sim *sim, worker_pool *pool, const unsigned char *actions)
+{
+	sim_job job;
+
+	job.sim = sim;
+	job.actions = actions;
+	atomic_init(&job.won, 0);
+	pool_run(pool, sim_range, &job, sim->count, AGENT_GRAIN);
+	return (atomic_load(&job.won));
+}
+
+/**
+ * sim_range - Move a range of agents one tick, for the worker pool.
+ * @arg: The sim_job of the step.
+ * @from: The first agent.
+ * @to: One past the last agent.
+ *
+ * Description: The rules of movement and check_win, on the bitset of the
+ * whole map: turning, then moving along each axis in turn unless it would
+ * end in a wall.
+ **/
+void sim_range(void *arg, int from, int to)
+{
+	sim_job *job = arg;
+	agent_sim *sim = job->sim;
+	const solve_grid *sg;
+	double_s play, dir, plane;
+	int i, act, sign, won = 0, win_value;
+
+	for (i = from; i < to; i++)
+	{
+		act = job->actions[i];
+		if (sim->done[i])
+			continue;
+		sg = &sim->levels[sim->level[i]].open;
+		if (act & AGENT_RIGHT)
+			rotate(&sim->angle[i], -1);
+		if (act & AGENT_LEFT)
+			rotate(&sim->angle[i], 1);
+		view_vectors(sim->angle[i], &dir, &plane);
+		play.x = sim->x[i];
+		play.y = sim->y[i];
+		for (sign = 1; sign >= -1; sign -= 2)
+		{
+			if (!(act & (sign > 0 ? AGENT_UP : AGENT_DOWN)))
+				continue;
+			if (!solve_solid(sg, (int)(play.x + sign * dir.x * MOVE_SPEED),
+					 (int)play.y))
+				play.x += sign * dir.x * MOVE_SPEED;
+			if (!solve_solid(sg, (int)play.x,
+					 (int)(play.y + sign * dir.y * MOVE_SPEED)))
+				play.y += sign * dir.y * MOVE_SPEED;
+		}
+		sim->x[i] = play.x;
+		sim->y[i] = play.y;
+		sim->dir_x[i] = dir.x;
+		sim->dir_y[i] = dir.y;
+		sim->plane_x[i] = plane.x;
+		sim->plane_y[i] = plane.y;
+		win_value = 0;
+		won += check_win(play, sim->levels[sim->level[i]].win, &win_value);
+		sim->done[i] = win_value;
+	}
+	atomic_fetch_add(&job->won, won);
+}
+
+/**
+ * sim_free - Free a simulation and its levels.
+ * @sim: The simulation, may be NULL.
+ **/
+void sim_free(agent_sim *sim)
+{
+	int i;
+
+	if (sim == NULL)
+		return;
+	for (i = 0; sim->levels != NULL && i < sim->level_count; i++)
+	{
+		free(sim->levels[i].open.open);
+		free(sim->levels[i].cells);
+	}
+	free(sim->levels);
+	free(sim->level);
+	free(sim->x);
+	free(sim->y);
+	free(sim->angle);
+	free(sim->dir_x);
+	free(sim->dir_y);
+	free(sim->plane_x);
+	free(sim->plane_y);
+	free(sim->done);
+	free(sim);
+}
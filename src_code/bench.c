@@ -0,0 +1,187 @@
+#include "../maze.h"
+
+/**
+ * script_keys - Get the scripted input for a frame of the benchmark.
+ * @frame: The frame number within the level.
+ * @key_press: Output for the keys held during that frame.
+ *
+ * Description: The camera path is a fixed loop of walking, turning and
+ * backing up, so every run flies exactly the same route through a level.
+ * Collisions still apply, so the route exercises movement as well.
+ **/
+void script_keys(int frame, keys *key_press)
+{
+	static const keys script[] = {
+		{1, 0, 0, 0}, {1, 0, 0, 0}, {0, 0, 0, 1}, {1, 0, 0, 0},
+		{1, 0, 1, 0}, {0, 1, 0, 0}, {0, 0, 0, 1}, {1, 0, 0, 1}
+	};
+	int segments = sizeof(script) / sizeof(script[0]);
+
+	/* Each segment of the script is held for 30 frames */
+	*key_press = script[(frame / 30) % segments];
+}
+
+/**
+ * bench_level - Render a level headless along the scripted path.
+ * @stage: The level to fly through; its player pose is updated.
+ * @pool: The worker pool casting the rays.
+ * @kernel: The ray kernel to cast with.
+ * @instance: The offscreen instance of the render path (init_offscreen).
+ * @frames: The number of frames to render.
+ * @times: Output for the time of every frame, in nanoseconds.
+ * @cost: The ray cost counters to count every frame in, already started on
+ * the level (cost_level), or NULL; counting is not timed.
+ *
+ * Description: The line and batched paths draw through draw, as in the
+ * game, with their software renderer; the software path draws its frame
+ * with draw_frame_soft, as there is no texture to upload it to.
+ **/
+void bench_level(level *stage, worker_pool *pool, int kernel,
+		 SDL_Instance *instance, int frames, double *times,
+		 ray_cost *cost)
+{
+	ray_table rays;
+	columns cols;
+	keys key_press;
+	double start;
+	uint64_t traced, scope;
+	int frame;
+
+	rays.angle = -1;
+	for (frame = 0; frame < frames; frame++)
+	{
+		start = now_ns();
+		traced = trace_frame_begin();
+		script_keys(frame, &key_press);
+		movement(key_press, &stage->angle, &stage->play, stage->map);
+		grid_load_around(stage->map, stage->play);
+		scope = trace_begin();
+		cast_frame(pool, kernel, stage->map, stage->play, stage->angle,
+			   &rays, &cols);
+		trace_end(TRACE_CAST, scope);
+		scope = trace_begin();
+		if (instance->mode == RENDER_SOFT)
+			draw_frame_soft(instance->pixels, instance->tex, pool,
+					stage->map, &cols);
+		else
+			draw(*instance, pool, stage->map, &cols);
+		trace_end(TRACE_DRAW, scope);
+		trace_frame_end(traced);
+		times[frame] = now_ns() - start;
+		if (cost != NULL)
+			cost_frame(cost, stage->map, cost->level, &rays, &cols);
+	}
+}
+
+/**
+ * bench_load - Time the loading of a level file.
+ * @file: The path of the level file.
+ *
+ * Return: The best time of LOAD_RUNS loads, in nanoseconds, or -1 if the
+ * level cannot be loaded.
+ *
+ * Description: A load is everything create_map does before the first
+ * frame: mapping the file, parsing it or checking its header, and loading
+ * the chunks around the player. After the first run the file is in the
+ * page cache, so this is the cost of parsing, not of the disk.
+ **/
+double bench_load(char *file)
+{
+	double best = -1, start, time;
+	double_s play;
+	int_s win;
+	grid *map;
+	int run, angle;
+
+	for (run = 0; run < LOAD_RUNS; run++)
+	{
+		start = now_ns();
+		map = create_map(file, &play, &win, &angle);
+		time = now_ns() - start;
+		if (map == NULL)
+			return (-1);
+		free_map(map);
+		if (best < 0 || time < best)
+			best = time;
+	}
+	return (best);
+}
+
+/**
+ * run_bench - Benchmark the renderer headless on every level.
+ * @game: The levels to render, from the first one.
+ * @opt: The options: frames per level, render path, threads, kernel and
+ * verification.
+ *
+ * Return: 0 on success, 1 if the buffers cannot be allocated, a level
+ * cannot be loaded or the kernel does not match the scalar one.
+ *
+ * Description: Frames are rendered by the render path of -r, offscreen
+ * (init_offscreen), with no window, no SDL initialization and no vsync:
+ * the software path with textured walls, floor, ceiling and sprites into
+ * its framebuffer, the line and batched paths with a software renderer.
+ * Levels are loaded one ahead as in the game, but the prefetch is waited
+ * for before a level is timed so it does not compete with the rendering.
+ * Each level is reported on its own, with its size and load time,
+ * followed by the totals over all levels.
+ **/
+int run_bench(world *game, options *opt)
+{
+	int frames = opt->bench, failed, lvl, next = 0;
+	level *stage = &game->stage;
+	worker_pool *pool;
+	SDL_Instance instance;
+	double *times;
+	ray_cost *cost = NULL;
+	uint64_t steps = 0;
+
+	failed = init_offscreen(&instance, opt->render);
+	times = malloc(sizeof(double) * frames * game->count);
+	pool = pool_create(opt->threads);
+	if (opt->cost)
+		cost = cost_create();
+	if (failed || times == NULL || pool == NULL ||
+	    (opt->cost && cost == NULL))
+	{
+		close_offscreen(instance);
+		free(times);
+		pool_destroy(pool);
+		cost_free(cost);
+		return (1);
+	}
+	printf("%d thread(s), %s kernel, %s render path\n", opt->threads,
+	       kernel_name(opt->kernel), render_name(opt->render));
+	for (lvl = 0; next == 0; lvl++, next = world_advance(game))
+	{
+		world_sync(game);
+		printf("level %d: %dx%d cells, %.1f KB, %d entities, start (%d, %d), "
+		       "win (%d, %d), loaded in %.3f ms\n", lvl + 1,
+		       stage->map->width, stage->map->height,
+		       stage->map->size / 1e3, stage->map->ents->count,
+		       (int)stage->play.x, (int)stage->play.y, stage->win.x,
+		       stage->win.y, bench_load(game->files[lvl]) / 1e6);
+		if (opt->verify)
+			failed |= verify_level(stage, pool, opt->kernel, frames,
+					       lvl + 1);
+		if (cost != NULL)
+			cost_level(cost, stage->map, lvl);
+		bench_level(stage, pool, opt->kernel, &instance, frames,
+			    times + lvl * frames, cost);
+		printf("level %d: ", lvl + 1);
+		report_bench(times + lvl * frames, frames);
+		if (cost != NULL)
+			printf("level %d: %.1f DDA steps per column, hottest cell "
+			       "(%d, %d) with %u steps\n", lvl + 1,
+			       (double)(cost->total - steps) / frames / SCREEN_WIDTH,
+			       cost->hottest.x, cost->hottest.y, cost->heat_max);
+		steps = cost != NULL ? cost->total : 0;
+	}
+	printf("total:   ");
+	report_bench(times, frames * lvl);
+	cost_report(cost);
+	cost_free(cost);
+	pool_destroy(pool);
+	close_offscreen(instance);
+	free(times);
+	return (failed || next < 0);
+}
@@ -0,0 +1,58 @@
+#include "../maze_core.h"
+
+/**
+ * now_ns - Read the monotonic clock.
+ *
+ * Return: The current time in nanoseconds.
+ **/
+double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+/**
+ * cmp_double - Compare two doubles for qsort.
+ * @a: Pointer to the first double.
+ * @b: Pointer to the second double.
+ *
+ * Return: Negative, zero or positive as a is less, equal or greater than b.
+ **/
+int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
+
+/**
+ * report_bench - Print the statistics of a series of frame times.
+ * @times: The frame times in nanoseconds; sorted in place.
+ * @count: The number of frames.
+ *
+ * Description: Prints frames per second, the median, 99th percentile and
+ * worst frame time, and the mean time spent per screen column, then
+ * whether the 99th percentile fits in the FRAME_BUDGET_NS frame budget.
+ **/
+void report_bench(double *times, int count)
+{
+	double total = 0, p99;
+	int i;
+
+	if (count == 0)
+		return;
+	for (i = 0; i < count; i++)
+		total += times[i];
+	qsort(times, count, sizeof(double), cmp_double);
+	/* The smallest time at least 99% of the frames are within */
+	p99 = times[(int)ceil(count * 0.99) - 1];
+	printf("%d frames, %.1f fps, p50 %.3f ms, p99 %.3f ms, max %.3f ms, ",
+	       count, count / (total / 1e9), times[count / 2] / 1e6,
+	       p99 / 1e6, times[count - 1] / 1e6);
+	printf("%.1f ns/column, p99 %s the %.3f ms budget\n",
+	       total / count / SCREEN_WIDTH,
+	       p99 <= FRAME_BUDGET_NS ? "within" : "OVER",
+	       FRAME_BUDGET_NS / 1e6);
+}
@@ -0,0 +1,118 @@
+#include "../maze.h"
+
+/**
+ * compare_columns - Compare two casts of a frame column by column.
+ * @want: The cast of the scalar kernel.
+ * @got: The cast of the kernel under test.
+ * @diff: The tally to add the differences to.
+ *
+ * Description: Distances are compared bit for bit, and for columns that
+ * hit the same cell and side the relative error is tracked as well (a
+ * wall at distance 0 has none).
+ **/
+void compare_columns(columns *want, columns *got, kernel_diff *diff)
+{
+	double err;
+	int screen_x;
+
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		diff->columns++;
+		if (want->cell[screen_x].x != got->cell[screen_x].x ||
+		    want->cell[screen_x].y != got->cell[screen_x].y ||
+		    want->side[screen_x] != got->side[screen_x])
+		{
+			diff->cells++;
+			continue;
+		}
+		if (memcmp(&want->dist[screen_x], &got->dist[screen_x],
+			   sizeof(double)) == 0)
+			continue;
+		diff->dists++;
+		if (want->dist[screen_x] == 0)
+			continue;
+		err = fabs(got->dist[screen_x] - want->dist[screen_x]) /
+			fabs(want->dist[screen_x]);
+		if (err > diff->max_err)
+			diff->max_err = err;
+		diff->sum_err += err;
+	}
+}
+
+/**
+ * verify_kernel - Compare a ray kernel with the scalar one on a level.
+ * @stage: The level to fly through; its player pose is left untouched.
+ * @pool: The worker pool casting the rays.
+ * @kernel: The kernel to check.
+ * @frames: The number of frames of the scripted path to check.
+ * @diff: Output for the differences, over all frames.
+ *
+ * Return: 0 on success, 1 if the buffers cannot be allocated.
+ **/
+int verify_kernel(level *stage, worker_pool *pool, int kernel, int frames,
+		  kernel_diff *diff)
+{
+	level copy = *stage;
+	ray_table rays;
+	columns *want, *got;
+	keys key_press;
+	int frame;
+
+	memset(diff, 0, sizeof(kernel_diff));
+	rays.angle = -1;
+	want = malloc(sizeof(columns));
+	got = malloc(sizeof(columns));
+	if (want == NULL || got == NULL)
+	{
+		free(want);
+		free(got);
+		return (1);
+	}
+	for (frame = 0; frame < frames; frame++)
+	{
+		script_keys(frame, &key_press);
+		movement(key_press, &copy.angle, &copy.play, copy.map);
+		grid_load_around(copy.map, copy.play);
+		cast_frame(NULL, KERNEL_SCALAR, copy.map, copy.play, copy.angle,
+			   &rays, want);
+		cast_frame(pool, kernel, copy.map, copy.play, copy.angle,
+			   &rays, got);
+		compare_columns(want, got, diff);
+	}
+	free(want);
+	free(got);
+	return (0);
+}
+
+/**
+ * verify_level - Compare a ray kernel with the scalar one and report it.
+ * @stage: The level to fly through.
+ * @pool: The worker pool casting the rays.
+ * @kernel: The kernel to compare with the scalar one.
+ * @frames: The number of frames of the scripted path to compare.
+ * @number: The number of the level, for the report.
+ *
+ * Return: 1 if a kernel meant to be exact differs from the scalar one, or
+ * on allocation failure, 0 otherwise. The fixed-point kernel trades
+ * precision for speed, so for it the differences are only reported.
+ **/
+int verify_level(level *stage, worker_pool *pool, int kernel, int frames,
+		 int number)
+{
+	kernel_diff diff;
+
+	if (verify_kernel(stage, pool, kernel, frames, &diff) != 0)
+		return (1);
+	if (diff.cells == 0 && diff.dists == 0)
+	{
+		printf("level %d: verified, identical to the scalar kernel\n",
+		       number);
+		return (0);
+	}
+	printf("level %d: %ld of %ld columns hit another cell or side, ",
+	       number, diff.cells, diff.columns);
+	printf("%ld at another distance (max error %.2e, mean %.2e)\n",
+	       diff.dists, diff.max_err,
+	       diff.dists ? diff.sum_err / diff.dists : 0.0);
+	return (kernel != KERNEL_FIXED);
+}
@@ -0,0 +1,127 @@
+#include "../maze.h"
+
+/* Reciprocal of 1.x for the RECIP_BITS-bit fractions x, scaled by 2^43 */
+static uint32_t recip_table[1 << RECIP_BITS];
+static pthread_once_t recip_once = PTHREAD_ONCE_INIT;
+
+/**
+ * fixed_init - Build the reciprocal table of the fixed-point kernel.
+ *
+ * Description: Entry i holds 2^43 / (2^RECIP_BITS + i + 0.5), the middle of
+ * the range of mantissas that share those leading bits, so the relative
+ * error of a lookup stays below 2^-(RECIP_BITS + 1) at any magnitude.
+ **/
+void fixed_init(void)
+{
+	int i;
+
+	for (i = 0; i < 1 << RECIP_BITS; i++)
+		recip_table[i] = (uint32_t)((double)((int64_t)1 << 43) /
+					    ((1 << RECIP_BITS) + i + 0.5) + 0.5);
+}
+
+/**
+ * fixed_recip - Reciprocal of a 16.16 ray direction component.
+ * @r: The component, in 16.16 fixed point.
+ *
+ * Return: |1 / r| in 16.16, or FIX_FAR when the ray is aligned with the
+ * other axis (r is 0) and never crosses a grid line of this one.
+ *
+ * Description: |r| is normalized so that its leading one is bit 31; the
+ * next RECIP_BITS bits pick the table entry and the normalization shift
+ * scales the result back. No division, no sqrt.
+ **/
+int64_t fixed_recip(int32_t r)
+{
+	uint32_t mag = r < 0 ? -(uint32_t)r : (uint32_t)r;
+	int lz;
+
+	if (mag == 0)
+		return (FIX_FAR);
+	lz = __builtin_clz(mag);
+	return (recip_table[((mag << lz) >> (31 - RECIP_BITS)) &
+			    ((1 << RECIP_BITS) - 1)] >> (31 - lz));
+}
+
+/**
+ * fixed_column - Cast the ray of one screen column in 16.16 fixed point.
+ * @map: The grid of the maze map.
+ * @cam: The player position, direction and plane in 16.16.
+ * @screen_x: The screen column the ray is cast for.
+ * @cell: Output for the x/y map coordinates of the wall hit.
+ * @hit_side: Output for the side hit, 0 for N/S and 1 for E/W.
+ *
+ * Return: The perpendicular distance to the wall, converted to a double.
+ *
+ * Description: With grid deltas of |1 / ray| the side distance of the last
+ * step, minus one delta, is the perpendicular distance, so the wall
+ * distance needs no division either. Side distances are 64-bit so that
+ * FIX_FAR never overflows.
+ **/
+double fixed_column(grid *map, fixed_cam *cam, int screen_x, int_s *cell,
+		    int *hit_side)
+{
+	int32_t cam_x, dir_x, dir_y, frac_x, frac_y;
+	int64_t del_x, del_y, side_x, side_y;
+	int step_x, step_y, hit = 0;
+
+	cam_x = ((2 * screen_x - SCREEN_WIDTH) * FIX_ONE) / SCREEN_WIDTH;
+	dir_x = cam->dir_x +
+		(int32_t)(((int64_t)cam->plane_x * cam_x) >> FIX_SHIFT);
+	dir_y = cam->dir_y +
+		(int32_t)(((int64_t)cam->plane_y * cam_x) >> FIX_SHIFT);
+	del_x = fixed_recip(dir_x);
+	del_y = fixed_recip(dir_y);
+	cell->x = (int)(cam->pos_x >> FIX_SHIFT);
+	cell->y = (int)(cam->pos_y >> FIX_SHIFT);
+	frac_x = cam->pos_x & (FIX_ONE - 1);
+	frac_y = cam->pos_y & (FIX_ONE - 1);
+	step_x = dir_x < 0 ? -1 : 1;
+	step_y = dir_y < 0 ? -1 : 1;
+	side_x = ((dir_x < 0 ? frac_x : FIX_ONE - frac_x) * del_x) >> FIX_SHIFT;
+	side_y = ((dir_y < 0 ? frac_y : FIX_ONE - frac_y) * del_y) >> FIX_SHIFT;
+	do {
+		if (side_x < side_y)
+		{
+			side_x += del_x;
+			cell->x += step_x;
+			hit = 0;
+		}
+		else
+		{
+			side_y += del_y;
+			cell->y += step_y;
+			hit = 1;
+		}
+	} while (!grid_solid(map, cell->x, cell->y));
+	*hit_side = hit;
+	return ((hit == 0 ? side_x - del_x : side_y - del_y) / (double)FIX_ONE);
+}
+
+/**
+ * cast_fixed_range - Cast a range of screen columns in fixed point.
+ * @job: The frame being cast.
+ * @from: The first column to cast.
+ * @to: One past the last column to cast.
+ *
+ * Description: The camera is converted to 16.16 once per range, the
+ * player position in 64 bits, as maps are up to MAP_MAX cells across. The
+ * position must be positive, which the sentinel ring guarantees.
+ **/
+void cast_fixed_range(cast_job *job, int from, int to)
+{
+	fixed_cam cam;
+	int screen_x;
+
+	pthread_once(&recip_once, fixed_init);
+	cam.pos_x = (int64_t)(job->play.x * FIX_ONE);
+	cam.pos_y = (int64_t)(job->play.y * FIX_ONE);
+	cam.dir_x = (int32_t)(job->dir.x * FIX_ONE);
+	cam.dir_y = (int32_t)(job->dir.y * FIX_ONE);
+	cam.plane_x = (int32_t)(job->plane.x * FIX_ONE);
+	cam.plane_y = (int32_t)(job->plane.y * FIX_ONE);
+	for (screen_x = from; screen_x < to; screen_x++)
+		job->out->dist[screen_x] = fixed_column(job->map, &cam, screen_x,
+							&job->out->cell[screen_x],
+							&job->out->side[screen_x]);
+}
@@ -0,0 +1,109 @@
+#include "../maze.h"
+
+/**
+ * cast_range - Cast the rays of a range of screen columns.
+ * @arg: The cast_job describing the frame.
+ * @from: The first column to cast.
+ * @to: One past the last column to cast.
+ *
+ * Description: Every column writes only its own slot of the per-column
+ * arrays, so ranges can be cast concurrently without any locking. The packet
+ * kernel takes the columns PACKET_SIZE at a time; whatever is left over is
+ * cast one column at a time. Whatever the kernel, where the rays hit
+ * their wall is then worked out from the distance (wall_hits).
+ **/
+void cast_range(void *arg, int from, int to)
+{
+	cast_job *job = arg;
+	columns *out = job->out;
+	int screen_x = from;
+
+	if (job->kernel == KERNEL_FIXED)
+		cast_fixed_range(job, from, to);
+	else if (job->kernel == KERNEL_SKIP)
+		for (; screen_x < to; screen_x++)
+			out->dist[screen_x] = skip_column(job->map, job->play,
+							  job->rays, screen_x,
+							  &out->cell[screen_x],
+							  &out->side[screen_x]);
+	else
+	{
+		if (job->kernel == KERNEL_SIMD)
+			for (; screen_x + PACKET_SIZE <= to; screen_x += PACKET_SIZE)
+				job->trace(job, screen_x);
+		for (; screen_x < to; screen_x++)
+			out->dist[screen_x] = cast_column(job->map, job->play,
+							  job->rays, screen_x,
+							  &out->cell[screen_x],
+							  &out->side[screen_x]);
+	}
+	wall_hits(job, from, to);
+}
+
+/**
+ * wall_hits - Work out where the rays of a range of columns hit their wall.
+ * @job: The cast_job describing the frame, its columns already cast.
+ * @from: The first column.
+ * @to: One past the last column.
+ *
+ * Description: A ray that stopped on an x grid line (a N/S face) hit it at
+ * y = play.y + dist * dir.y, and one on a y grid line at the matching x.
+ * The fraction of the cell is flipped on the faces seen from the other
+ * side, so textures are never drawn mirrored.
+ **/
+void wall_hits(cast_job *job, int from, int to)
+{
+	const ray_table *rays = job->rays;
+	columns *out = job->out;
+	double hit;
+	int screen_x, flip;
+
+	for (screen_x = from; screen_x < to; screen_x++)
+	{
+		if (out->side[screen_x] == 0)
+		{
+			hit = job->play.y + out->dist[screen_x] * rays->dir_y[screen_x];
+			flip = rays->dir_x[screen_x] > 0;
+		}
+		else
+		{
+			hit = job->play.x + out->dist[screen_x] * rays->dir_x[screen_x];
+			flip = rays->dir_y[screen_x] < 0;
+		}
+		hit -= floor(hit);
+		out->hit[screen_x] = flip && hit > 0 ? 1 - hit : hit;
+	}
+}
+
+/**
+ * cast_frame - Cast the rays of every screen column of a frame.
+ * @pool: The worker pool to spread the columns over, or NULL.
+ * @kernel: The ray kernel to use (KERNEL_SCALAR, KERNEL_SIMD, KERNEL_FIXED or
+ * KERNEL_SKIP).
+ * @map: The grid of the maze map.
+ * @play: The player's current x/y position in the maze.
+ * @angle: The view angle of the player.
+ * @rays: The ray table of the caller, refilled when the angle changed.
+ * @out: Output for the distance, hit cell and side of every column.
+ *
+ * Description: Rays are independent of each other, so the columns are cast
+ * in parallel. Drawing the results stays on the calling (SDL) thread, and so
+ * does refilling the ray table, before any worker reads it.
+ **/
+void cast_frame(worker_pool *pool, int kernel, grid *map, double_s play,
+		int angle, ray_table *rays, columns *out)
+{
+	cast_job job;
+
+	view_rays(rays, angle);
+	out->play = play;
+	out->angle = angle;
+	job.kernel = kernel;
+	job.trace = pick_packet_trace();
+	job.map = map;
+	job.play = play;
+	view_vectors(angle, &job.dir, &job.plane);
+	job.rays = rays;
+	job.out = out;
+	pool_run(pool, cast_range, &job, SCREEN_WIDTH, COLUMN_GRAIN);
+}
@@ -0,0 +1,172 @@
+#include "../maze.h"
+
+/* Four lanes of doubles and of 64-bit integers (masks, map coordinates) */
+typedef double v4df __attribute__((vector_size(32)));
+typedef long long v4di __attribute__((vector_size(32)));
+
+/**
+ * struct packet - State of PACKET_SIZE adjacent rays, one per vector lane
+ * @pos_x: The x position of the player in every lane
+ * @pos_y: The y position of the player in every lane
+ * @cell_fx: The x map cell of the player in every lane
+ * @cell_fy: The y map cell of the player in every lane
+ * @dir_x: The x direction of every ray
+ * @dir_y: The y direction of every ray
+ * @del_x: The distance along every ray between two x grid lines
+ * @del_y: The distance along every ray between two y grid lines
+ * @side_x: The distance along every ray to its next x grid line
+ * @side_y: The distance along every ray to its next y grid line
+ * @first_x: The distance along every ray to its first x grid line
+ * @first_y: The distance along every ray to its first y grid line
+ * @count_x: The number of x steps every ray has taken
+ * @count_y: The number of y steps every ray has taken
+ * @step_x: The x step direction of every ray (-1 or 1)
+ * @step_y: The y step direction of every ray (-1 or 1)
+ **/
+typedef struct packet
+{
+	v4df pos_x, pos_y, cell_fx, cell_fy;
+	v4df dir_x, dir_y, del_x, del_y, side_x, side_y;
+	v4df first_x, first_y, count_x, count_y;
+	v4di step_x, step_y;
+} packet;
+
+/* Lanes of a mask that are all ones take a, the others take b */
+#define SELECT(mask, a, b) \
+	((v4df)(((v4di)(a) & (mask)) | ((v4di)(b) & ~(mask))))
+
+/**
+ * packet_setup - Set up the rays of PACKET_SIZE adjacent columns at once.
+ * @job: The frame being cast.
+ * @screen_x: The first of the columns.
+ * @p: Output for the ray state of every lane.
+ *
+ * Description: Lane for lane the same IEEE operations as ray_setup and
+ * check_ray_dir, so every lane starts from bit-identical values. Ray
+ * directions and grid deltas are loaded from the ray table of the view.
+ **/
+static inline __attribute__((always_inline))
+void packet_setup(cast_job *job, int screen_x, packet *p)
+{
+	const ray_table *rays = job->rays;
+	v4df pos_x = p->pos_x, pos_y = p->pos_y;
+	v4di neg_x, neg_y;
+
+	memcpy(&p->dir_x, rays->dir_x + screen_x, sizeof(v4df));
+	memcpy(&p->dir_y, rays->dir_y + screen_x, sizeof(v4df));
+	memcpy(&p->del_x, rays->del_x + screen_x, sizeof(v4df));
+	memcpy(&p->del_y, rays->del_y + screen_x, sizeof(v4df));
+	neg_x = p->dir_x < 0;
+	neg_y = p->dir_y < 0;
+	p->step_x = neg_x | 1;
+	p->step_y = neg_y | 1;
+	p->side_x = SELECT(neg_x, (pos_x - p->cell_fx) * p->del_x,
+			   (p->cell_fx + 1.0 - pos_x) * p->del_x);
+	p->side_y = SELECT(neg_y, (pos_y - p->cell_fy) * p->del_y,
+			   (p->cell_fy + 1.0 - pos_y) * p->del_y);
+	p->first_x = p->side_x;
+	p->first_y = p->side_y;
+	p->count_x = (v4df){0, 0, 0, 0};
+	p->count_y = (v4df){0, 0, 0, 0};
+}
+
+/**
+ * packet_trace - Cast the rays of PACKET_SIZE adjacent columns at once.
+ * @job: The frame being cast.
+ * @screen_x: The first of the columns.
+ *
+ * Description: Every iteration advances all lanes still in flight by one
+ * grid square with masked vector arithmetic: a lane steps along x where its
+ * x side distance is the smaller one and along y elsewhere, exactly like
+ * get_wall_dist, with side distances counted from the first grid lines the
+ * same way. Lanes that hit a wall drop out of the active mask and stop
+ * moving; their map reads keep landing on the wall they hit, so all lanes
+ * are read without branching. A map read is a chunk lookup and a load of
+ * the row's word of the chunk's solidity bitmap per lane, then one vector
+ * shift for all lanes.
+ **/
+static inline __attribute__((always_inline))
+void packet_trace(cast_job *job, int screen_x)
+{
+	const grid *map = job->map;
+	columns *out = job->out;
+	v4di cell_x, cell_y, word, hit, active, m, mx, my;
+	v4df ones = {1, 1, 1, 1};
+	packet p;
+	int lane;
+
+	cell_x = (v4di){0, 0, 0, 0} + (int)job->play.x;
+	cell_y = (v4di){0, 0, 0, 0} + (int)job->play.y;
+	p.pos_x = (v4df){0, 0, 0, 0} + job->play.x;
+	p.pos_y = (v4df){0, 0, 0, 0} + job->play.y;
+	p.cell_fx = (v4df){0, 0, 0, 0} + (int)job->play.x;
+	p.cell_fy = (v4df){0, 0, 0, 0} + (int)job->play.y;
+	packet_setup(job, screen_x, &p);
+	hit = (v4di){0, 0, 0, 0};
+	active = (v4di){-1, -1, -1, -1};
+	do {
+		m = p.side_x < p.side_y;
+		mx = m & active;
+		my = ~m & active;
+		p.count_x += (v4df)((v4di)ones & mx);
+		p.count_y += (v4df)((v4di)ones & my);
+		p.side_x = p.first_x + p.count_x * p.del_x;
+		p.side_y = p.first_y + p.count_y * p.del_y;
+		cell_x += p.step_x & mx;
+		cell_y += p.step_y & my;
+		hit = (hit & ~active) | (my & 1);
+		for (lane = 0; lane < PACKET_SIZE; lane++)
+			word[lane] = grid_chunk(map, cell_x[lane], cell_y[lane])->
+				solid[cell_x[lane] & (CHUNK_SIZE - 1)];
+		active &= ((word >> (cell_y & (CHUNK_SIZE - 1))) & 1) - 1;
+	} while (active[0] | active[1] | active[2] | active[3]);
+	for (lane = 0; lane < PACKET_SIZE; lane++)
+	{
+		out->cell[screen_x + lane].x = cell_x[lane];
+		out->cell[screen_x + lane].y = cell_y[lane];
+		out->side[screen_x + lane] = hit[lane];
+		out->dist[screen_x + lane] = hit[lane] == 0 ?
+			(cell_x[lane] - job->play.x + (1 - p.step_x[lane]) / 2) /
+			p.dir_x[lane] :
+			(cell_y[lane] - job->play.y + (1 - p.step_y[lane]) / 2) /
+			p.dir_y[lane];
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * packet_trace_avx2 - packet_trace compiled for AVX2 (4 lanes per register).
+ * @job: The frame being cast.
+ * @screen_x: The first of the columns.
+ **/
+__attribute__((target("avx2")))
+void packet_trace_avx2(cast_job *job, int screen_x)
+{
+	packet_trace(job, screen_x);
+}
+#endif
+
+/**
+ * packet_trace_base - packet_trace compiled for the baseline instruction
+ * set, which is SSE2 (2 lanes per register) on x86-64.
+ * @job: The frame being cast.
+ * @screen_x: The first of the columns.
+ **/
+void packet_trace_base(cast_job *job, int screen_x)
+{
+	packet_trace(job, screen_x);
+}
+
+/**
+ * pick_packet_trace - Pick the build of packet_trace for the running CPU.
+ *
+ * Return: The AVX2 build when the CPU supports it, else the baseline one.
+ **/
+packet_fn pick_packet_trace(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+		return (packet_trace_avx2);
+#endif
+	return (packet_trace_base);
+}
@@ -1,80 +1,58 @@
-#include "../maze.h"
+#include "../maze_core.h"
 
 /**
- * get_line_count - Counts the number of lines in a file.
- * @file_string: The file path to the maze layout.
- * Return: The total number of lines in the file, or 0 if the file cannot be opened.
- **/
-size_t get_line_count(char *file_string)
-{
-	FILE *maze_file;
-	char *line = NULL;
-	size_t lines = 0;
-	size_t line_len = 0;
-	ssize_t read;
-
-	maze_file = fopen(file_string, "r");
-	if (maze_file == NULL)
-	{
-		fprintf(stderr, "File does not exist\n");
-		return (0);
-	}
-
-	/* Count each line in the file */
-	while ((read = getline(&line, &line_len, maze_file)) != -1)
-	{
-		lines++;
-	}
-	fclose(maze_file);
-	free(line);
-
-	return (lines);
-}
-
-/**
- * get_char_count - Counts the number of characters in a line.
- * @line: The string representing a single line from the file.
- * Return: The number of characters in the string (excluding null terminator).
+ * level_error - Report an error in a level file.
+ * @lt: The level file being parsed.
+ * @line: The line of the error, from 1, or 0 for the file as a whole.
+ * @col: The column of the error, from 1, or 0 for the line as a whole.
+ * @fmt: printf format of the message, followed by its arguments.
+ *
+ * Description: Errors are printed on stderr as "file:line:col: message",
+ * the way compilers report them, so editors can jump to the bad cell.
  **/
-size_t get_char_count(char *line)
+void level_error(level_text *lt, int line, size_t col, const char *fmt, ...)
 {
-	size_t char_count = 0;
+	va_list args;
 
-	/* Iterate through the string until the null terminator */
-	while (line[char_count] != '\0')
-		char_count++;
-	return (char_count);
+	fprintf(stderr, "%s:", lt->file);
+	if (line > 0)
+		fprintf(stderr, "%d:", line);
+	if (line > 0 && col > 0)
+		fprintf(stderr, "%zu:", col);
+	fprintf(stderr, " ");
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
 }
 
 /**
- * plot_grid_points - Maps specific characters in the maze to points.
- * @maze: The 2D array representing the maze.
+ * plot_grid_points - Finds the player and win squares of the maze.
  * @play: The player's x and y position in the maze.
  * @win: The x and y coordinates of the winning square.
  * @cur_char: Current character being processed in the line.
  * @maze_line: The current line number being processed in the maze.
- * @line: The current line being read from the file.
+ * @line: The current line of the file.
  * @found_win: Flag indicating if the win square has been found.
- * 
- * Description: Processes each character of the maze, mapping player 'p', 
- * win 'w', and other maze elements to their respective positions in the 
- * 2D array. Adjusts the player's start position and marks the win square.
+ *
+ * Description: Processes each character of the maze, picking up the
+ * player 'p' and win 'w' positions. Adjusts the player's start position
+ * and marks the win square. The cells themselves are read from the mapped
+ * file, a chunk at a time, as the player gets near them (chunk_load).
  **/
-void plot_grid_points(char **maze, double_s *play, int_s *win, size_t cur_char,
-		      size_t maze_line, char *line, int *found_win)
+void plot_grid_points(double_s *play, int_s *win, size_t cur_char,
+		      size_t maze_line, const char *line, int *found_win)
 {
 	if (line[cur_char] == 'p')  /* Player's starting position */
 	{
 		play->y = cur_char;
 		play->x = maze_line;
-		maze[maze_line][cur_char] = '0';  /* Mark player's start as an empty space */
 	}
 	else if (line[cur_char] == 'w')  /* Win position */
 	{
 		*found_win = 1;
 		win->y = cur_char;
 		win->x = maze_line;
-		maze[maze_line][cur_char] = '0';  /* Mark win square as an empty space */
 	}
 	else
 	{
@@ -84,59 +62,281 @@ void plot_grid_points(char **maze, double_s *play, int_s *win, size_t cur_char,
 			win->y = cur_char;
 			win->x = maze_line;
 		}
-		maze[maze_line][cur_char] = line[cur_char];  /* Set the current character in the maze */
 	}
 }
 
 /**
- * create_map - Creates a 2D array to represent the maze from the file.
+ * row_entities - Add the entities of a row of a level file.
+ * @lt: The level file being parsed.
+ * @line: The row.
+ * @len: The number of cells of the row.
+ *
+ * Return: 0 on success, 1 if there is no memory left for them; the error
+ * has been reported.
+ *
+ * Description: 'k' cells hold a key and 'e' cells an enemy, standing in
+ * the middle of the cell. They are found with memchr, like the player.
+ **/
+int row_entities(level_text *lt, const char *line, size_t len)
+{
+	static const char marks[] = {'k', 'e'};
+	static const int types[] = {ENTITY_KEY, ENTITY_ENEMY};
+	const char *mark;
+	size_t i;
+
+	for (i = 0; i < sizeof(marks); i++)
+		for (mark = memchr(line, marks[i], len); mark != NULL;
+		     mark = memchr(mark + 1, marks[i], line + len - mark - 1))
+			if (entity_add(lt->ents, lt->height + 0.5,
+				       mark - line + 0.5, types[i]) != 0)
+			{
+				level_error(lt, lt->height + 1, mark - line + 1,
+					    "out of memory");
+				return (1);
+			}
+	return (0);
+}
+
+/**
+ * parse_row - Index and check one row of a level file.
+ * @lt: The level file being parsed.
+ * @start: Offset of the row in the file.
+ * @end: Offset of the newline ending the row, or the size of the file.
+ * @play: Output for the player's start position.
+ * @win: Output for the win square.
+ *
+ * Return: 0 on success, 1 if the row is not valid.
+ *
+ * Description: A carriage return before the newline is part of the line
+ * ending, not of the row. Every other byte must be a printable character:
+ * '0' is empty, 'p' and 'w' are the player start and win square, 'k' and
+ * 'e' are empty cells holding a key and an enemy, and anything else is a
+ * wall. The player start must appear exactly once.
+ * The check is a branchless pass the compiler vectorizes, and the few
+ * 'p' and 'w' cells are found with memchr, so a row costs about as much
+ * as reading it.
+ **/
+int parse_row(level_text *lt, size_t start, size_t end, double_s *play,
+	      int_s *win)
+{
+	const char *line = lt->text + start, *mark;
+	size_t len, col;
+	row_span *grown;
+	int bad = 0;
+
+	len = end - start - (end > start && lt->text[end - 1] == '\r');
+	if (len >= MAP_MAX || lt->height >= MAP_MAX)
+	{
+		level_error(lt, lt->height + 1, 0, "the map is larger than %d cells "
+			    "on a side", MAP_MAX);
+		return (1);
+	}
+	for (col = 0; col < len; col++)
+		bad |= (unsigned char)(line[col] - '!') > '~' - '!';
+	if (bad)
+	{
+		for (col = 0; (unsigned char)(line[col] - '!') <= '~' - '!'; col++)
+			;
+		level_error(lt, lt->height + 1, col + 1, "invalid character 0x%02x",
+			    (unsigned char)line[col]);
+		return (1);
+	}
+	for (mark = memchr(line, 'p', len); mark != NULL;
+	     mark = memchr(mark + 1, 'p', line + len - mark - 1))
+	{
+		if (lt->found_play++)
+		{
+			level_error(lt, lt->height + 1, mark - line + 1,
+				    "second player start 'p'");
+			return (1);
+		}
+		plot_grid_points(play, win, mark - line, lt->height, line,
+				 &lt->found_win);
+	}
+	for (mark = memchr(line, 'w', len); mark != NULL;
+	     mark = memchr(mark + 1, 'w', line + len - mark - 1))
+		plot_grid_points(play, win, mark - line, lt->height, line,
+				 &lt->found_win);
+	if (row_entities(lt, line, len) != 0)
+		return (1);
+	if (lt->height == lt->cap)
+	{
+		lt->cap = lt->cap > 0 ? lt->cap * 2 : 256;
+		grown = realloc(lt->rows, sizeof(row_span) * lt->cap);
+		if (grown == NULL)
+		{
+			level_error(lt, lt->height + 1, 0, "out of memory");
+			return (1);
+		}
+		lt->rows = grown;
+	}
+	lt->rows[lt->height].start = start;
+	lt->rows[lt->height++].len = len;
+	if ((int)len > lt->width)
+		lt->width = len;
+	return (0);
+}
+
+/**
+ * parse_level - Index and check a whole level file in one pass.
+ * @lt: The level file, mapped in memory, with nothing parsed yet.
+ * @play: Output for the player's start position.
+ * @win: Output for the win square.
+ *
+ * Return: 0 on success, 1 if the level is not valid; the error has been
+ * reported with its line and column.
+ *
+ * Description: Rows end at a newline, found with memchr, or at the end of
+ * the file, so a final newline does not add an empty row. Each row is
+ * checked and indexed as it is found; the file is never copied. Without a
+ * 'w', the win square is the last '0' of the map, looked for backwards
+ * from the end once the rows are known.
+ **/
+int parse_level(level_text *lt, double_s *play, int_s *win)
+{
+	const char *newline, *line;
+	size_t start = 0, end;
+	int row, col;
+
+	while (start < lt->size)
+	{
+		newline = memchr(lt->text + start, '\n', lt->size - start);
+		end = newline != NULL ? (size_t)(newline - lt->text) : lt->size;
+		if (parse_row(lt, start, end, play, win) != 0)
+			return (1);
+		start = end + 1;
+	}
+	if (lt->width == 0)
+	{
+		level_error(lt, 0, 0, "the map has no cells");
+		return (1);
+	}
+	if (!lt->found_play)
+	{
+		level_error(lt, 0, 0, "no player start 'p'");
+		return (1);
+	}
+	for (row = lt->height - 1; row >= 0 && !lt->found_win; row--)
+	{
+		line = lt->text + lt->rows[row].start;
+		for (col = lt->rows[row].len - 1; col >= 0 && line[col] != '0'; col--)
+			;
+		if (col >= 0)
+		{
+			plot_grid_points(play, win, col, row, line, &lt->found_win);
+			break;
+		}
+	}
+	return (0);
+}
+
+/**
+ * text_map - Creates the grid of a text level.
+ * @lt: The level file, mapped in memory, with nothing parsed yet.
+ * @play: Structure to hold player's x and y position.
+ * @win: Structure to hold the win square's x and y coordinates.
+ * Return: The grid, without any chunk loaded, or NULL if it fails.
+ *
+ * Description: Indexes the rows of the file in a single pass into a
+ * chunked grid sized by the longest line, and populates the player's start
+ * position and win position based on characters in the file. Any cell
+ * that is not '0', 'p', 'w', 'k' or 'e' is solid, and so is everything
+ * outside the file. The row index and the entities, with the win marker
+ * added last, are moved from @lt to the grid.
+ **/
+grid *text_map(level_text *lt, double_s *play, int_s *win)
+{
+	grid *maze;
+
+	madvise((void *)lt->text, lt->size, MADV_SEQUENTIAL);  /* Parse only */
+	if (parse_level(lt, play, win) != 0)
+		return (NULL);
+	if (entity_add(lt->ents, win->x + 0.5, win->y + 0.5, ENTITY_WIN) != 0)
+	{
+		level_error(lt, 0, 0, "out of memory");
+		return (NULL);
+	}
+	maze = grid_create(lt->width, lt->height);
+	if (maze == NULL)
+		return (NULL);
+	madvise((void *)lt->text, lt->size, MADV_RANDOM);  /* Chunks read a few rows apart */
+	maze->rows = lt->rows;
+	lt->rows = NULL;
+	maze->ents = lt->ents;
+	lt->ents = NULL;
+	return (maze);
+}
+
+/**
+ * create_map - Creates the grid representing the maze from the file.
  * @file_string: The path to the maze layout file.
  * @play: Structure to hold player's x and y position.
  * @win: Structure to hold the win square's x and y coordinates.
- * @map_h: Pointer to store the height (number of lines) of the maze.
- * Return: A 2D array representing the maze, or NULL if it fails.
+ * @angle: The player's view angle; only a compiled level sets it.
+ * Return: The grid of the maze, or NULL if it fails.
  *
- * Description: Reads the maze layout from a file, dynamically allocates
- * memory for the 2D maze array, and populates the player's start position
- * and win position based on characters in the file.
+ * Description: Maps the maze layout file in memory, and reads it as a
+ * level compiled by mazec if it starts with LEVEL_MAGIC, or as a text
+ * level otherwise. The mapping is kept: only the chunks around the player
+ * are loaded from it, here and then by grid_load_around as the player
+ * moves.
  **/
-char **create_map(char *file_string, double_s *play, int_s *win, size_t *map_h)
+grid *create_map(char *file_string, double_s *play, int_s *win, int *angle)
 {
-	FILE *maze_file;
-	char **maze, *line = NULL;
-	ssize_t read = 0;
-	size_t line_count, maze_line, char_count, cur_char, bufsize;
-	int found_win = 0;
+	level_text lt = {0};
+	struct stat st;
+	grid *maze;
+	void *text;
+	int fd;
 
-	found_win = 0;
-	maze_line = 0;
-	line_count = get_line_count(file_string);  /* Get number of lines in the maze file */
-	*map_h = line_count;  /* Store the maze height */
-	if (line_count == 0)
+	lt.file = file_string;
+	fd = open(file_string, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		perror(file_string);
+		if (fd >= 0)
+			close(fd);
+		return (NULL);
+	}
+	if (st.st_size == 0)
+	{
+		level_error(&lt, 0, 0, "the map has no cells");
+		close(fd);
 		return (NULL);
-	maze = malloc(sizeof(int *) * line_count);  /* Allocate memory for 2D maze array */
+	}
+	text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);  /* The mapping keeps the file */
+	if (text == MAP_FAILED)
+	{
+		perror(file_string);
+		return (NULL);
+	}
+	lt.text = text;
+	lt.size = st.st_size;
+	lt.ents = entities_create();
+	if (lt.ents == NULL)
+	{
+		level_error(&lt, 0, 0, "out of memory");
+		maze = NULL;
+	}
+	else if (lt.size >= sizeof(level_header) &&
+		 memcmp(text, LEVEL_MAGIC, sizeof(((level_header *)0)->magic)) == 0)
+		maze = compiled_map(&lt, play, win, angle);
+	else
+		maze = text_map(&lt, play, win);
+	free(lt.rows);  /* Only left if the level was rejected */
+	entities_free(lt.ents);
 	if (maze == NULL)
+	{
+		munmap(text, lt.size);
 		return (NULL);
-	maze_file = fopen(file_string, "r");  /* Open the maze file */
-	if (maze_file == NULL)
+	}
+	maze->text = lt.text;
+	maze->size = lt.size;
+	if (grid_load_around(maze, *play) != 0)
+	{
+		grid_free(maze);
 		return (NULL);
-	read = getline(&line, &bufsize, maze_file);
-	while (read != -1)  /* Read each line of the maze file */
-	{
-		char_count = get_char_count(line);  /* Get the character count for each line */
-		maze[maze_line] = malloc(sizeof(char) * char_count + 1);  /* Allocate memory for each line */
-		if (maze == NULL)
-			return (NULL);
-		for (cur_char = 0; cur_char < char_count; cur_char++)
-		{
-			/* Map each character in the line to a specific point in the maze */
-			plot_grid_points(maze, play, win, cur_char, maze_line, line, &found_win);
-		}
-		maze_line++;
-		read = getline(&line, &bufsize, maze_file);  /* Read the next line */
 	}
-	fclose(maze_file);  /* Close the maze file */
-	free(line);  /* Free the buffer for reading lines */
 	return (maze);
 }
-
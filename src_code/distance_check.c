@@ -1,4 +1,4 @@
-#include "../maze.h"
+#include "../maze_core.h"
 
 /**
  * check_ray_dir - Determines the direction and distance for the ray to move.
@@ -45,7 +45,7 @@ void check_ray_dir(int_s *step, double_s *dist_side, double_s ray_pos,
 
 /**
  * get_wall_dist - Calculates the distance from the player to the next wall.
- * @map: The 2D array representing the maze map (with '0' as empty space and '1' as walls).
+ * @map: The grid of the maze map (with '0' as empty space and anything else solid).
  * @dist_side: Current x/y distance to the next side of a grid square.
  * @coord: Player's current x/y coordinates in the map.
  * @step: The direction of movement (x/y axis: -1 for negative, 1 for positive).
@@ -58,42 +58,264 @@ void check_ray_dir(int_s *step, double_s *dist_side, double_s ray_pos,
  * Description: Using a ray-casting algorithm, this function tracks the movement 
  * of the ray in discrete steps across the grid. It checks whether the ray hits a wall 
  * at each step and calculates the exact distance from the player's position to the 
- * first wall encountered.
+ * first wall encountered. The side distances are counted from the first grid
+ * lines, as first side + steps * delta, rather than accumulated, so that the
+ * state after any number of steps can be worked out directly: the skip kernel
+ * jumps to it and still traces exactly the same ray.
  **/
-double get_wall_dist(char **map, double_s *dist_side, int_s *coord,
+double get_wall_dist(grid *map, double_s *dist_side, int_s *coord,
 		      int_s *step, double_s *dist_del, int *hit_side,
 		      double_s *ray_dir, double_s *ray_pos)
 {
+	/* Work on local copies, so the state of the ray stays in registers */
+	double_s first = *dist_side, side = *dist_side, delta = *dist_del;
+	int_s cell = *coord, move = *step, count = {0, 0};
+	int hit = *hit_side;
 	double wall_dist;
-	int hit_wall = 0;  /* Flag to check if the wall has been hit */
 
-	while (hit_wall == 0)
+	while (1)
 	{
 		/* Move the ray to the next grid square based on distance */
-		if (dist_side->x < dist_side->y)
+		if (side.x < side.y)
 		{
-			dist_side->x += dist_del->x;  /* Increment distance to next x grid boundary */
-			coord->x += step->x;  /* Move in the x direction */
-			*hit_side = 0;  /* Hit a N/S wall */
+			count.x++;
+			side.x = first.x + count.x * delta.x;  /* Distance to next x grid boundary */
+			cell.x += move.x;  /* Move in the x direction */
+			hit = 0;  /* Hit a N/S wall */
 		}
 		else
 		{
-			dist_side->y += dist_del->y;  /* Increment distance to next y grid boundary */
-			coord->y += step->y;  /* Move in the y direction */
-			*hit_side = 1;  /* Hit an E/W wall */
+			count.y++;
+			side.y = first.y + count.y * delta.y;  /* Distance to next y grid boundary */
+			cell.y += move.y;  /* Move in the y direction */
+			hit = 1;  /* Hit an E/W wall */
 		}
 
-		/* Check if the ray has hit a wall (non-zero character in the map) */
-		if (map[coord->x][coord->y] > '0')
-			hit_wall = 1;
+		/* Check if the ray has hit a wall (solid bit set in the map) */
+		if (grid_solid(map, cell.x, cell.y))
+			break;
 	}
 
 	/* Calculate the actual distance from the player to the wall */
-	if (*hit_side == 0)
-		wall_dist = (coord->x - ray_pos->x + (1 - step->x) / 2) / ray_dir->x;  /* Wall hit on N/S */
-	else
-		wall_dist = (coord->y - ray_pos->y + (1 - step->y) / 2) / ray_dir->y;  /* Wall hit on E/W */
-	
+	wall_dist = wall_distance(cell, move, hit, *ray_pos, *ray_dir);
+
+	*dist_side = side;
+	*coord = cell;
+	*hit_side = hit;
 	return (wall_dist);
 }
 
+/**
+ * ray_setup - Work out the starting state of the ray of a screen column.
+ * @play: The player's current x/y position in the maze.
+ * @rays: The ray directions and grid deltas of the current view.
+ * @screen_x: The screen column the ray is cast for.
+ * @ray: Output for the ray direction, grid deltas, steps and side distances.
+ *
+ * Description: Hoisted out of cast_column so that the whole ray state is
+ * built in one place; packet_setup mirrors it lane for lane. The direction
+ * and grid deltas only depend on the view angle, so they come from the
+ * table filled by view_rays.
+ **/
+void ray_setup(double_s play, const ray_table *rays, int screen_x,
+	       ray_state *ray)
+{
+	ray->dir.x = rays->dir_x[screen_x];
+	ray->dir.y = rays->dir_y[screen_x];
+	ray->cell.x = (int)play.x;
+	ray->cell.y = (int)play.y;
+
+	/* Distance between grid lines (x and y) */
+	ray->delta.x = rays->del_x[screen_x];
+	ray->delta.y = rays->del_y[screen_x];
+
+	check_ray_dir(&ray->step, &ray->side, play, ray->cell, ray->delta,
+		      ray->dir);
+}
+
+/**
+ * wall_distance - Perpendicular distance from the player to a wall hit.
+ * @cell: The x/y map coordinates of the wall that was hit.
+ * @step: The x/y step direction of the ray.
+ * @hit_side: The side that was hit, 0 for N/S and 1 for E/W.
+ * @ray_pos: The starting position of the ray.
+ * @ray_dir: The x/y direction of the ray.
+ * Return: The distance, measured along the view direction to avoid fisheye.
+ **/
+double wall_distance(int_s cell, int_s step, int hit_side, double_s ray_pos,
+		     double_s ray_dir)
+{
+	if (hit_side == 0)
+		return ((cell.x - ray_pos.x + (1 - step.x) / 2) / ray_dir.x);  /* Wall hit on N/S */
+	return ((cell.y - ray_pos.y + (1 - step.y) / 2) / ray_dir.y);  /* Wall hit on E/W */
+}
+
+/**
+ * cast_column - Casts the ray of one screen column into the maze.
+ * @map: The grid of the maze map.
+ * @play: The player's current x/y position in the maze.
+ * @rays: The ray directions and grid deltas of the current view.
+ * @screen_x: The screen column the ray is cast for.
+ * @coord: Output for the x/y map coordinates of the wall that was hit.
+ * @hit_side: Output for the side (0 for N/S, 1 for E/W) that was hit.
+ * Return: The perpendicular distance from the player to the wall.
+ *
+ * Description: Shared by every render path so that the line renderer and
+ * the software framebuffer trace exactly the same rays.
+ **/
+double cast_column(grid *map, double_s play, const ray_table *rays,
+		   int screen_x, int_s *coord, int *hit_side)
+{
+	ray_state ray;
+
+	*hit_side = 0;
+	ray_setup(play, rays, screen_x, &ray);
+	*coord = ray.cell;
+	return (get_wall_dist(map, &ray.side, coord, &ray.step, &ray.delta,
+			      hit_side, &ray.dir, &play));
+}
+
+/**
+ * skip_count - Count the grid lines of one axis a ray crosses before a time.
+ * @first: The distance along the ray to its first grid line on this axis.
+ * @delta: The distance along the ray between two grid lines on this axis.
+ * @from: The number of lines already crossed.
+ * @to: An upper bound on the answer.
+ * @until: The distance of the crossing on the other axis to stop before.
+ * @strict: 1 if a crossing at exactly @until comes after it (x lines, as
+ * get_wall_dist steps along y on ties), 0 if it comes before (y lines).
+ *
+ * Return: The number of lines of this axis crossed before @until.
+ *
+ * Description: A division gives a first guess, which the same comparisons
+ * get_wall_dist makes then correct, so rounding cannot change the answer.
+ **/
+static inline int skip_count(double first, double delta, int from, int to,
+			     double until, int strict)
+{
+	double guess = (until - first) / delta;
+	int n;
+
+	n = guess < from ? from : guess > to ? to : (int)guess;
+	while (n > from && (strict ? first + (n - 1) * delta >= until :
+			    first + (n - 1) * delta > until))
+		n--;
+	while (n < to && (strict ? first + n * delta < until :
+			  first + n * delta <= until))
+		n++;
+	return (n);
+}
+
+/**
+ * skip_box - Jump a ray to where it leaves an empty square of cells.
+ * @ray: The starting state of the ray.
+ * @reach: The radius of the empty square around the current cell.
+ * @count_x: The x steps taken so far, updated.
+ * @count_y: The y steps taken so far, updated.
+ *
+ * Description: Within @reach more steps on both axes the ray stays inside
+ * the square. Of the two crossings that would leave it, the first one in
+ * get_wall_dist's order (x before y only when strictly closer) is where
+ * the ray goes next; every crossing of the other axis before it has been
+ * taken, and skip_count finds how many that is.
+ **/
+static inline void skip_box(const ray_state *ray, int reach, int *count_x,
+			    int *count_y)
+{
+	int to_x = *count_x + reach, to_y = *count_y + reach;
+	double out_x = ray->side.x + to_x * ray->delta.x;
+	double out_y = ray->side.y + to_y * ray->delta.y;
+
+	if (out_x < out_y)
+	{
+		*count_y = skip_count(ray->side.y, ray->delta.y, *count_y, to_y,
+				      out_x, 0);
+		*count_x = to_x;
+	}
+	else
+	{
+		*count_x = skip_count(ray->side.x, ray->delta.x, *count_x, to_x,
+				      out_y, 1);
+		*count_y = to_y;
+	}
+}
+
+/**
+ * skip_wall_dist - Trace a ray to its wall, skipping empty space.
+ * @map: The grid of the maze map, with its distance field.
+ * @ray: The starting state of the ray.
+ * @play: The player's current x/y position in the maze.
+ * @coord: Output for the x/y map coordinates of the wall that was hit.
+ * @hit_side: Output for the side (0 for N/S, 1 for E/W) that was hit.
+ * Return: The perpendicular distance from the player to the wall.
+ *
+ * Description: The same traversal as get_wall_dist, but wherever the
+ * distance field shows at least SKIP_MIN empty cells all around, the ray
+ * jumps straight out of that square instead of stepping through it one
+ * cell at a time. Near walls it steps like get_wall_dist, so it hits the
+ * same cell, side and distance. The field is 0 exactly on walls, so it
+ * also stands in for the solidity bitmap: one byte read per step. Fields
+ * stop at chunk borders, so a jump never leaves the chunk it starts in.
+ **/
+double skip_wall_dist(grid *map, const ray_state *ray, double_s play,
+		      int_s *coord, int *hit_side)
+{
+	double_s side = ray->side;
+	int_s count = {0, 0}, cell = ray->cell;
+	int hit = 0, reach;
+
+	reach = grid_field(map, cell.x, cell.y) - 1;
+	while (1)
+	{
+		if (reach >= SKIP_MIN)
+		{
+			skip_box(ray, reach, &count.x, &count.y);
+			cell.x = ray->cell.x + count.x * ray->step.x;
+			cell.y = ray->cell.y + count.y * ray->step.y;
+			side.x = ray->side.x + count.x * ray->delta.x;
+			side.y = ray->side.y + count.y * ray->delta.y;
+		}
+		if (side.x < side.y)
+		{
+			count.x++;
+			side.x = ray->side.x + count.x * ray->delta.x;
+			cell.x += ray->step.x;
+			hit = 0;
+		}
+		else
+		{
+			count.y++;
+			side.y = ray->side.y + count.y * ray->delta.y;
+			cell.y += ray->step.y;
+			hit = 1;
+		}
+		/* Walls are the cells at distance 0 of the field */
+		reach = grid_field(map, cell.x, cell.y) - 1;
+		if (reach < 0)
+			break;
+	}
+	*coord = cell;
+	*hit_side = hit;
+	return (wall_distance(*coord, ray->step, hit, play, ray->dir));
+}
+
+/**
+ * skip_column - Casts the ray of one screen column, skipping empty space.
+ * @map: The grid of the maze map, with its distance field.
+ * @play: The player's current x/y position in the maze.
+ * @rays: The ray directions and grid deltas of the current view.
+ * @screen_x: The screen column the ray is cast for.
+ * @coord: Output for the x/y map coordinates of the wall that was hit.
+ * @hit_side: Output for the side (0 for N/S, 1 for E/W) that was hit.
+ * Return: The perpendicular distance from the player to the wall.
+ *
+ * Description: cast_column for the skip kernel, sharing its ray setup.
+ **/
+double skip_column(grid *map, double_s play, const ray_table *rays,
+		   int screen_x, int_s *coord, int *hit_side)
+{
+	ray_state ray;
+
+	ray_setup(play, rays, screen_x, &ray);
+	return (skip_wall_dist(map, &ray, play, coord, hit_side));
+}
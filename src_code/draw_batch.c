@@ -0,0 +1,116 @@
+#include "../maze.h"
+
+/**
+ * draw_batch - Render a frame as a few batches of rectangles.
+ * @instance: The SDL instance holding the renderer and the batches.
+ * @map: The grid of the maze layout with walls and empty spaces.
+ * @cols: The rays of every screen column, already cast by cast_frame.
+ *
+ * Description: The sky, the ground and the wall slices are sorted into
+ * one batch per color and each batch is drawn with a single
+ * SDL_RenderFillRects call, so a frame costs at most BATCH_GROUPS draw
+ * calls and color changes instead of three of each per column.
+ **/
+void draw_batch(SDL_Instance instance, grid *map, columns *cols)
+{
+	uint64_t start;
+
+	if (instance.cache != NULL)
+	{
+		SDL_SetRenderTarget(instance.renderer, instance.cache);
+		instance.stats->states++;
+	}
+	start = trace_begin();
+	batch_frame(instance.batch, map, cols);
+	batch_submit(instance);
+	trace_end(TRACE_WALLS, start);
+	if (present_cached(instance))
+	{
+		cost_overlay(instance);
+		start = trace_begin();
+		SDL_RenderPresent(instance.renderer);
+		trace_end(TRACE_PRESENT, start);
+	}
+}
+
+/**
+ * wall_group - Get the batch of a wall slice.
+ * @wall: The map character of the wall that was hit.
+ * @hit_side: Indicator of whether the wall was hit on the N/S or E/W side.
+ *
+ * Return: The batch of the slice, one per color given by wall_color.
+ **/
+int wall_group(char wall, int hit_side)
+{
+	return (BATCH_WALLS + wall_type(wall, hit_side));
+}
+
+/**
+ * batch_frame - Sort the rectangles of a frame into their batches.
+ * @b: The batches, emptied first.
+ * @map: The grid of the maze layout with walls.
+ * @cols: The distance, hit cell and side of every screen column.
+ *
+ * Description: The sky and the ground are one rectangle each, drawn first
+ * and covered by the walls. A wall slice that continues the last
+ * rectangle of its batch, on the next column with the same rows, widens
+ * it instead of adding one, so flat walls seen head on are a handful of
+ * rectangles.
+ **/
+void batch_frame(batch *b, grid *map, columns *cols)
+{
+	SDL_Rect *last;
+	int_s cell;
+	int screen_x, start, end, g;
+
+	memset(b->count, 0, sizeof(b->count));
+	b->rects[BATCH_SKY][b->count[BATCH_SKY]++] =
+		(SDL_Rect){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT / 2};
+	b->rects[BATCH_GROUND][b->count[BATCH_GROUND]++] =
+		(SDL_Rect){0, SCREEN_HEIGHT / 2, SCREEN_WIDTH,
+			   SCREEN_HEIGHT - SCREEN_HEIGHT / 2};
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		cell = cols->cell[screen_x];
+		wall_slice(cols->dist[screen_x], &start, &end);
+		g = wall_group(grid_cell(map, cell.x, cell.y), cols->side[screen_x]);
+		last = b->count[g] > 0 ? &b->rects[g][b->count[g] - 1] : NULL;
+		if (last != NULL && last->x + last->w == screen_x &&
+		    last->y == start && last->h == end - start + 1)
+			last->w++;
+		else
+			b->rects[g][b->count[g]++] =
+				(SDL_Rect){screen_x, start, 1, end - start + 1};
+	}
+}
+
+/**
+ * batch_submit - Draw the batches of a frame.
+ * @instance: The SDL instance holding the renderer and the batches.
+ *
+ * Description: Batches are drawn in order, sky and ground first; each
+ * non-empty one takes one color change and one draw call.
+ **/
+void batch_submit(SDL_Instance instance)
+{
+	static const char walls[] = "1234#";
+	batch *b = instance.batch;
+	Uint32 color;
+	int g;
+
+	for (g = 0; g < BATCH_GROUPS; g++)
+	{
+		if (b->count[g] == 0)
+			continue;
+		if (g == BATCH_SKY || g == BATCH_GROUND)
+			color = g == BATCH_SKY ? SKY_COLOR : GROUND_COLOR;
+		else
+			color = wall_color(walls[(g - BATCH_WALLS) / 2],
+					   (g - BATCH_WALLS) % 2);
+		SDL_SetRenderDrawColor(instance.renderer, (color >> 16) & 0xFF,
+				       (color >> 8) & 0xFF, color & 0xFF, 0xFF);
+		SDL_RenderFillRects(instance.renderer, b->rects[g], b->count[g]);
+		instance.stats->states++;
+		instance.stats->calls++;
+	}
+}
@@ -0,0 +1,150 @@
+#include "../maze.h"
+
+/* Whether the overlay is drawn over the frame */
+static int cost_shown;
+
+/**
+ * cost_toggle - Show or hide the ray cost overlay.
+ *
+ * Return: 1 if it is now shown, 0 if hidden.
+ **/
+int cost_toggle(void)
+{
+	cost_shown = !cost_shown;
+	return (cost_shown);
+}
+
+/**
+ * cost_overlay - Draw the ray cost overlay over the frame.
+ * @instance: The SDL instance, with the counters of the frame on screen.
+ *
+ * Description: Drawn just before the frame is presented, on every render
+ * path, when shown and when rays are counted: a top-down heatmap of the
+ * cells around the player in the top left corner (cost_heatmap), and a bar
+ * of the steps of every column along the bottom (cost_bars). Like
+ * draw_batch, the rectangles are grouped by color and every group is one
+ * draw call.
+ **/
+void cost_overlay(SDL_Instance instance)
+{
+	ray_cost *rc = instance.cost;
+	Uint32 color;
+	int g;
+
+	if (rc == NULL || !cost_shown || rc->frames == 0)
+		return;
+	memset(rc->count, 0, sizeof(rc->count));
+	cost_heatmap(rc);
+	cost_bars(rc);
+	for (g = 0; g < COST_GROUPS; g++)
+	{
+		if (rc->count[g] == 0)
+			continue;
+		if (g == COST_BACK || g == COST_WALL)
+			color = g == COST_BACK ? 0x000000 : 0x505050;
+		else
+			color = cost_shade(g - COST_SHADES);
+		SDL_SetRenderDrawColor(instance.renderer, (color >> 16) & 0xFF,
+				       (color >> 8) & 0xFF, color & 0xFF, 0xFF);
+		SDL_RenderFillRects(instance.renderer, rc->rects[g], rc->count[g]);
+		instance.stats->states++;
+		instance.stats->calls++;
+	}
+}
+
+/**
+ * cost_heatmap - Sort the cells of the heatmap into their groups.
+ * @rc: The counters of the level.
+ *
+ * Description: HEAT_CELLS x HEAT_CELLS cells centered on the player, map
+ * rows down and columns across, HEAT_SCALE pixels each: walls in grey,
+ * and the cells rays crossed in a shade of their steps, on a log scale up
+ * to the hottest cell of the level. The cell of the player, which every
+ * ray crosses, is usually the brightest. Runs of a row in one group are
+ * one rectangle.
+ **/
+void cost_heatmap(ray_cost *rc)
+{
+	int top = (int)rc->play.x - HEAT_CELLS / 2;
+	int left = (int)rc->play.y - HEAT_CELLS / 2;
+	int i, j, g, bins = cost_bin(rc->heat_max) + 1;
+	uint32_t heat;
+	SDL_Rect *last;
+
+	rc->rects[COST_BACK][rc->count[COST_BACK]++] = (SDL_Rect){
+		HEAT_SCALE, HEAT_SCALE, HEAT_CELLS * HEAT_SCALE,
+		HEAT_CELLS * HEAT_SCALE};
+	for (i = 0; i < HEAT_CELLS; i++)
+		for (j = 0; j < HEAT_CELLS; j++)
+		{
+			heat = cost_heat(rc, top + i, left + j);
+			if (heat > 0)
+				g = COST_SHADES + cost_bin(heat) * HEAT_SHADES / bins;
+			else if (grid_solid(rc->map, top + i, left + j))
+				g = COST_WALL;
+			else
+				continue;
+			last = rc->count[g] > 0 ? &rc->rects[g][rc->count[g] - 1] :
+				NULL;
+			if (last != NULL && last->y == (i + 1) * HEAT_SCALE &&
+			    last->x + last->w == (j + 1) * HEAT_SCALE)
+				last->w += HEAT_SCALE;
+			else
+				rc->rects[g][rc->count[g]++] = (SDL_Rect){
+					(j + 1) * HEAT_SCALE, (i + 1) * HEAT_SCALE,
+					HEAT_SCALE, HEAT_SCALE};
+		}
+}
+
+/**
+ * cost_bars - Sort the column cost bar into its groups.
+ * @rc: The counters of the frame.
+ *
+ * Description: A bar per screen column along the bottom of the screen,
+ * as high and as bright as the steps of its ray, relative to the costliest
+ * column of the frame. Adjacent bars of one height and shade are one
+ * rectangle.
+ **/
+void cost_bars(ray_cost *rc)
+{
+	uint32_t most = 1;
+	SDL_Rect *last;
+	int screen_x, g, h;
+
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+		if (rc->column[screen_x] > most)
+			most = rc->column[screen_x];
+	rc->rects[COST_BACK][rc->count[COST_BACK]++] = (SDL_Rect){
+		0, SCREEN_HEIGHT - COST_BAR_HEIGHT, SCREEN_WIDTH, COST_BAR_HEIGHT};
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		h = (uint64_t)rc->column[screen_x] * COST_BAR_HEIGHT / most;
+		g = COST_SHADES + (uint64_t)rc->column[screen_x] * (HEAT_SHADES - 1) /
+			most;
+		if (h == 0)
+			continue;
+		last = rc->count[g] > 0 ? &rc->rects[g][rc->count[g] - 1] : NULL;
+		if (last != NULL && last->x + last->w == screen_x && last->h == h)
+			last->w++;
+		else
+			rc->rects[g][rc->count[g]++] = (SDL_Rect){
+				screen_x, SCREEN_HEIGHT - h, 1, h};
+	}
+}
+
+/**
+ * cost_shade - Get the color of a shade of the overlay.
+ * @shade: The shade, 0 to HEAT_SHADES - 1, coldest first.
+ *
+ * Return: The color, 0xRRGGBB, from dark blue through red to yellow.
+ **/
+Uint32 cost_shade(int shade)
+{
+	static const Uint32 shades[HEAT_SHADES] = {
+		0x101060, 0x2020A0, 0x6020A0, 0xA02080, 0xE02040, 0xF06020,
+		0xF0A020, 0xFFF040
+	};
+
+	return (shades[shade < 0 ? 0 : shade < HEAT_SHADES ? shade :
+		       HEAT_SHADES - 1]);
+}
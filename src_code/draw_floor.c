@@ -0,0 +1,113 @@
+#include "../maze.h"
+
+/**
+ * cast_floor - Cast the floor and ceiling of a frame into the framebuffer.
+ * @pool: The worker pool to spread the rows over, or NULL.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels.
+ * @tex: The floor and ceiling textures.
+ * @cols: The rays of the frame, for the pose they were cast from.
+ *
+ * Description: Every row of the screen is written in full, the floor below
+ * the horizon and the ceiling above it; the walls are drawn over them
+ * afterwards. Rows are independent of each other, so they are cast in
+ * parallel.
+ **/
+void cast_floor(worker_pool *pool, Uint32 *pixels, const atlas *tex,
+		columns *cols)
+{
+	floor_job job;
+	double_s dir, plane;
+
+	view_vectors(cols->angle, &dir, &plane);
+	job.pixels = pixels;
+	job.tex = tex;
+	job.play = cols->play;
+	job.left.x = dir.x - plane.x;
+	job.left.y = dir.y - plane.y;
+	job.step.x = 2 * plane.x / SCREEN_WIDTH;
+	job.step.y = 2 * plane.y / SCREEN_WIDTH;
+	pool_run(pool, floor_range, &job, SCREEN_HEIGHT, ROW_GRAIN);
+}
+
+/**
+ * floor_range - Cast a range of floor and ceiling rows.
+ * @arg: The floor_job describing the frame.
+ * @from: The first row to cast.
+ * @to: One past the last row to cast.
+ **/
+void floor_range(void *arg, int from, int to)
+{
+	const floor_job *job = arg;
+	int y;
+
+	for (y = from; y < to; y++)
+		floor_row(job, y);
+}
+
+/**
+ * floor_span - Write a row of floor or ceiling texels.
+ * @row: The row of the framebuffer.
+ * @texels: The floor or ceiling texture.
+ * @tex_x: The texture x of the first pixel, in 16.16.
+ * @tex_y: The texture y of the first pixel, in 16.16.
+ * @step_x: How much the texture x changes from a pixel to the next.
+ * @step_y: How much the texture y changes from a pixel to the next.
+ *
+ * Description: No branch and no dependency between pixels: the compiler
+ * vectorizes the texture coordinates, and with AVX2 the texel loads too.
+ **/
+static inline void floor_span(Uint32 *restrict row,
+			      const Uint32 *restrict texels, Uint32 tex_x,
+			      Uint32 tex_y, Uint32 step_x, Uint32 step_y)
+{
+	Uint32 u, v;
+	int screen_x;
+
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		u = ((tex_x + (Uint32)screen_x * step_x) >> FIX_SHIFT) &
+			(TEX_SIZE - 1);
+		v = ((tex_y + (Uint32)screen_x * step_y) >> FIX_SHIFT) &
+			(TEX_SIZE - 1);
+		row[screen_x] = texels[u * TEX_SIZE + v];
+	}
+}
+
+/**
+ * floor_row - Cast a row of the floor or of the ceiling.
+ * @job: The floor_job describing the frame.
+ * @y: The row to cast.
+ *
+ * Description: Everything seen on a row of the floor is at the same
+ * distance: the one at which a wall's foot lands on that row. Along the
+ * row, the point of the floor seen moves by the same step from a column to
+ * the next, so its texture coordinates are worked out once per row, in
+ * 16.16 fixed point, and floor_span only adds multiples of the step. The
+ * ceiling mirrors the floor across the horizon. Coordinates wrap around at
+ * 2^16 texels, a whole number of textures, so only the fraction of the
+ * cell the row starts on matters.
+ **/
+void floor_row(const floor_job *job, int y)
+{
+	const Uint32 *texels;
+	double dist, pos_x, pos_y;
+
+	/* Distance of the floor at the centre of the row */
+	if (y >= SCREEN_HEIGHT / 2)
+	{
+		dist = (SCREEN_HEIGHT / 2) / (y - SCREEN_HEIGHT / 2 + 0.5);
+		texels = job->tex->floor;
+	}
+	else
+	{
+		dist = (SCREEN_HEIGHT / 2) / (SCREEN_HEIGHT / 2 - y - 0.5);
+		texels = job->tex->ceiling;
+	}
+	pos_x = job->play.x + dist * job->left.x;
+	pos_y = job->play.y + dist * job->left.y;
+	floor_span(job->pixels + (size_t)y * SCREEN_WIDTH, texels,
+		   (Uint32)((pos_x - floor(pos_x)) * TEX_SIZE * FIX_ONE),
+		   (Uint32)((pos_y - floor(pos_y)) * TEX_SIZE * FIX_ONE),
+		   (Uint32)(int32_t)(dist * job->step.x * TEX_SIZE * FIX_ONE),
+		   (Uint32)(int32_t)(dist * job->step.y * TEX_SIZE * FIX_ONE));
+}
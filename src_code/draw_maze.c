@@ -3,20 +3,99 @@
 /**
  * draw - Render the game visuals (background, walls) on the screen.
  * @instance: The SDL instance containing the game window and renderer.
- * @map: 2D array representing the maze layout with walls and empty spaces.
- * @play: The player's current x/y position in the maze.
- * @dir: The direction vector representing where the player is facing.
- * @plane: The projection plane for the player's field of view.
+ * @pool: The worker pool, which the software path casts the floor with.
+ * @map: The grid of the maze layout with walls and empty spaces.
+ * @cols: The rays of every screen column, already cast by cast_frame.
  * 
  * Description: This function handles drawing both the background (sky and 
  * floor) and the walls of the maze, updating the screen with each frame.
+ * With the software and batched render paths the frame is handed to
+ * draw_soft or draw_batch instead. The frame is drawn into the cache
+ * texture when there is one.
  **/
-void draw(SDL_Instance instance, char **map, double_s play, double_s dir,
-	  double_s plane)
+void draw(SDL_Instance instance, worker_pool *pool, grid *map, columns *cols)
 {
+	uint64_t start;
+
+	instance.stats->frames++;
+	if (instance.mode == RENDER_SOFT)
+	{
+		draw_soft(instance, pool, map, cols);  // One texture upload per frame
+		return;
+	}
+	if (instance.mode == RENDER_BATCH)
+	{
+		draw_batch(instance, map, cols);  // A few batches of rectangles
+		return;
+	}
+	if (instance.cache != NULL)
+	{
+		SDL_SetRenderTarget(instance.renderer, instance.cache);
+		instance.stats->states++;
+	}
+	start = trace_begin();
 	draw_background(instance);  // Draw the sky and floor
-	draw_walls(map, play, instance, dir, plane);  // Draw the maze walls
-	SDL_RenderPresent(instance.renderer);  // Display the final rendered image
+	trace_end(TRACE_BACKGROUND, start);
+	start = trace_begin();
+	draw_walls(map, cols, instance);  // Draw the maze walls
+	trace_end(TRACE_WALLS, start);
+	if (present_cached(instance))
+	{
+		cost_overlay(instance);  // Ray cost of the frame, if shown
+		start = trace_begin();
+		SDL_RenderPresent(instance.renderer);  // Display the final rendered image
+		trace_end(TRACE_PRESENT, start);
+	}
+}
+
+/**
+ * present_cached - Present the last frame drawn again.
+ * @instance: The SDL instance holding the texture of the last frame.
+ *
+ * Return: 0 on success, 1 if there is no texture holding the frame (line
+ * path without render target support); the frame must be drawn again.
+ *
+ * Description: The last frame is kept in the software path's streaming
+ * texture or in the line path's render target; presenting it again is a
+ * single copy, without casting a ray or drawing a line. The ray cost
+ * overlay is drawn over the copy, not into the texture.
+ **/
+int present_cached(SDL_Instance instance)
+{
+	SDL_Texture *cached = instance.mode == RENDER_SOFT ? instance.frame :
+		instance.cache;
+	uint64_t start;
+
+	if (cached == NULL)
+		return (1);
+	start = trace_begin();
+	SDL_SetRenderTarget(instance.renderer, NULL);
+	SDL_RenderCopy(instance.renderer, cached, NULL, NULL);
+	cost_overlay(instance);
+	SDL_RenderPresent(instance.renderer);
+	trace_end(TRACE_PRESENT, start);
+	instance.stats->states++;
+	instance.stats->calls++;
+	return (0);
+}
+
+/**
+ * draw_report - Print the draw calls and state changes of a frame.
+ * @instance: The SDL instance holding the counts.
+ *
+ * Description: Counts are averaged over the frames drawn; the copies of
+ * a cached frame presented again while idle are added to them.
+ * SDL_RenderPresent itself is not counted.
+ **/
+void draw_report(SDL_Instance instance)
+{
+	draw_stats *stats = instance.stats;
+
+	if (stats->frames == 0)
+		return;
+	printf("draw: %ld frames, %.1f draw calls and %.1f state changes per "
+	       "frame\n", stats->frames, (double)stats->calls / stats->frames,
+	       (double)stats->states / stats->frames);
 }
 
 /**
@@ -40,73 +119,45 @@ void draw_background(SDL_Instance instance)
 		/* Draw the lighter brown ground */
 		SDL_SetRenderDrawColor(instance.renderer, 89, 60, 30, 0xFF);   // Ground color
 		SDL_RenderDrawLine(instance.renderer, x, SCREEN_HEIGHT / 2, x, SCREEN_HEIGHT);
+		instance.stats->states += 2;
+		instance.stats->calls += 2;
 	}
 }
 
 /**
- * draw_walls - Render the walls of the maze using raycasting.
- * @map: A 2D array representing the maze layout with walls.
- * @play: The player's current x/y position in the maze.
+ * draw_walls - Render the walls of the maze from the cast rays.
+ * @map: The grid of the maze layout with walls.
+ * @cols: The distance, hit cell and side of every screen column.
  * @instance: The SDL instance containing the renderer.
- * @dir: The direction vector representing where the player is facing.
- * @plane: The projection plane for rendering the player's field of view.
  * 
- * Description: This function uses raycasting to compute and draw the maze walls 
- * based on the player's position and direction. It calculates the distance from 
- * the player to the walls and renders the walls accordingly.
+ * Description: This function draws one wall slice per screen column, sized
+ * by the distance from the player to the wall that column's ray hit.
  **/
-void draw_walls(char **map, double_s play, SDL_Instance instance, double_s dir,
-		double_s plane)
+void draw_walls(grid *map, columns *cols, SDL_Instance instance)
 {
-	double_s ray_pos, ray_dir, dist_side, dist_del;
-	double wall_dist, cam_x;
-	int_s coord, step;
-	int wall_height, wall_start, wall_end, screen_x, hit_side;
+	int wall_start, wall_end, screen_x;
 
 	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
 	{
-		hit_side = 0;  // Reset hit side for each ray
-		cam_x = 2 * screen_x / (double)SCREEN_WIDTH - 1;  // Calculate camera x-coordinate for ray
-		ray_pos.x = play.x;
-		ray_pos.y = play.y;
-		ray_dir.x = dir.x + plane.x * cam_x;  // Calculate ray direction
-		ray_dir.y = dir.y + plane.y * cam_x;
-		coord.x = (int)ray_pos.x;
-		coord.y = (int)ray_pos.y;
-
-		// Calculate distance between grid lines (x and y)
-		dist_del.x = sqrt(1 + (ray_dir.y * ray_dir.y) / (ray_dir.x * ray_dir.x));
-		dist_del.y = sqrt(1 + (ray_dir.x * ray_dir.x) / (ray_dir.y * ray_dir.y));
-
-		// Determine which direction to step (left/right or up/down)
-		check_ray_dir(&step, &dist_side, ray_pos, coord, dist_del, ray_dir);
-
-		// Calculate distance to the wall
-		wall_dist = get_wall_dist(map, &dist_side, &coord, &step,
-					  &dist_del, &hit_side, &ray_dir, &ray_pos);
-
 		// Calculate height and position of the wall slice
-		wall_height = (int)(SCREEN_HEIGHT / wall_dist);
-		wall_start = -wall_height / 2 + SCREEN_HEIGHT / 2;
-		if (wall_start < 0)
-			wall_start = 0;
-		wall_end = wall_height / 2 + SCREEN_HEIGHT / 2;
-		if (wall_end >= SCREEN_HEIGHT)
-			wall_end = SCREEN_HEIGHT - 1;
+		wall_slice(cols->dist[screen_x], &wall_start, &wall_end);
 
 		// Choose the wall color based on the map and hit side
-		choose_color(instance, map, coord, hit_side);
+		choose_color(instance, map, cols->cell[screen_x],
+			     cols->side[screen_x]);
 
 		// Render the wall slice
 		SDL_RenderDrawLine(instance.renderer, screen_x, wall_start,
 				   screen_x, wall_end);
+		instance.stats->states++;
+		instance.stats->calls++;
 	}
 }
 
 /**
  * choose_color - Set the color for drawing the wall slice.
  * @instance: The SDL instance containing the renderer.
- * @map: The 2D array representing the maze layout with walls.
+ * @map: The grid of the maze layout with walls.
  * @coord: The current coordinates in the map where the wall was hit.
  * @hit_side: Indicator of whether the wall was hit on the N/S or E/W side.
  * 
@@ -114,45 +165,56 @@ void draw_walls(char **map, double_s play, SDL_Instance instance, double_s dir,
  * this function sets the color used to render the wall. Each wall type (1-4) 
  * has a different base color and a slightly darker shade for shadows.
  **/
-void choose_color(SDL_Instance instance, char **map, int_s coord, int hit_side)
+void choose_color(SDL_Instance instance, grid *map, int_s coord, int hit_side)
 {
-	switch (map[coord.x][coord.y])
+	Uint32 color = wall_color(grid_cell(map, coord.x, coord.y), hit_side);
+
+	SDL_SetRenderDrawColor(instance.renderer, (color >> 16) & 0xFF,
+			       (color >> 8) & 0xFF, color & 0xFF, 0xFF);
+}
+
+/**
+ * wall_color - Get the ARGB color of a wall slice.
+ * @wall: The map character of the wall that was hit.
+ * @hit_side: Indicator of whether the wall was hit on the N/S or E/W side.
+ * Return: The ARGB8888 color of the wall, darker on the E/W side.
+ *
+ * Description: Each wall type (1-4) has a different base color and a
+ * slightly darker shade for shadows. Unknown walls are steel gray.
+ **/
+Uint32 wall_color(char wall, int hit_side)
+{
+	switch (wall)
 	{
 		case '1':
-			/* Set color for deep blue walls */
-			if (hit_side == 0)
-				SDL_SetRenderDrawColor(instance.renderer, 0x00, 0x34, 0x66, 0xFF);  // Dark blue
-			else
-				SDL_SetRenderDrawColor(instance.renderer, 0x00, 0x28, 0x4D, 0xFF);  // Navy shadow
-			break;
+			/* Deep blue walls: dark blue, navy shadow */
+			return (hit_side == 0 ? 0xFF003466 : 0xFF00284D);
 		case '2':
-			/* Set color for dark green walls */
-			if (hit_side == 0)
-				SDL_SetRenderDrawColor(instance.renderer, 0x00, 0x5F, 0x37, 0xFF);  // Dark forest green
-			else
-				SDL_SetRenderDrawColor(instance.renderer, 0x00, 0x47, 0x2B, 0xFF);  // Shadow green
-			break;
+			/* Dark green walls: dark forest green, shadow green */
+			return (hit_side == 0 ? 0xFF005F37 : 0xFF00472B);
 		case '3':
-			/* Set color for charcoal gray walls */
-			if (hit_side == 0)
-				SDL_SetRenderDrawColor(instance.renderer, 0x36, 0x36, 0x36, 0xFF);  // Charcoal
-			else
-				SDL_SetRenderDrawColor(instance.renderer, 0x2C, 0x2C, 0x2C, 0xFF);  // Darker gray
-			break;
+			/* Charcoal gray walls: charcoal, darker gray */
+			return (hit_side == 0 ? 0xFF363636 : 0xFF2C2C2C);
 		case '4':
-			/* Set color for burnt orange walls */
-			if (hit_side == 0)
-				SDL_SetRenderDrawColor(instance.renderer, 0xD9, 0x6B, 0x00, 0xFF);  // Burnt orange
-			else
-				SDL_SetRenderDrawColor(instance.renderer, 0xA3, 0x52, 0x00, 0xFF);  // Dark burnt orange
-			break;
+			/* Burnt orange walls: burnt orange, dark burnt orange */
+			return (hit_side == 0 ? 0xFFD96B00 : 0xFFA35200);
 		default:
-			/* Set color for steel gray walls */
-			if (hit_side == 0)
-				SDL_SetRenderDrawColor(instance.renderer, 0x4B, 0x4B, 0x4B, 0xFF);  // Steel gray
-			else
-				SDL_SetRenderDrawColor(instance.renderer, 0x3A, 0x3A, 0x3A, 0xFF);  // Shadow gray
-			break;
+			/* Steel gray walls: steel gray, shadow gray */
+			return (hit_side == 0 ? 0xFF4B4B4B : 0xFF3A3A3A);
 	}
 }
 
+/**
+ * wall_type - Get the shade of a wall slice.
+ * @wall: The map character of the wall that was hit.
+ * @hit_side: Indicator of whether the wall was hit on the N/S or E/W side.
+ * Return: 2 * type + side, where type is 0-3 for walls 1-4 and 4 for any
+ * other wall: the index of the slice's texture, or of its batch past
+ * BATCH_WALLS.
+ **/
+int wall_type(char wall, int hit_side)
+{
+	int type = wall >= '1' && wall <= '4' ? wall - '1' : 4;
+
+	return (type * 2 + (hit_side != 0));
+}
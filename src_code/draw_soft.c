@@ -0,0 +1,194 @@
+#include "../maze.h"
+
+/**
+ * draw_soft - Render a frame through the software framebuffer.
+ * @instance: The SDL instance holding the framebuffer and streaming texture.
+ * @pool: The worker pool casting the floor and ceiling rows.
+ * @map: The grid of the maze layout with walls and empty spaces.
+ * @cols: The rays of every screen column, already cast by cast_frame.
+ *
+ * Description: Every pixel of the frame is written straight into the
+ * contiguous ARGB buffer, which is then uploaded to the GPU with a single
+ * SDL_UpdateTexture call and presented with a single copy. This replaces the
+ * thousands of per-column draw calls and color changes of the line path.
+ **/
+void draw_soft(SDL_Instance instance, worker_pool *pool, grid *map,
+	       columns *cols)
+{
+	uint64_t start;
+
+	draw_frame_soft(instance.pixels, instance.tex, pool, map, cols);
+	start = trace_begin();
+	SDL_UpdateTexture(instance.frame, NULL, instance.pixels,
+			  SCREEN_WIDTH * sizeof(Uint32));
+	trace_end(TRACE_UPLOAD, start);
+	instance.stats->calls++;
+	present_cached(instance);
+}
+
+/**
+ * draw_frame_soft - Draw a whole frame into the software framebuffer.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels.
+ * @tex: The wall, floor and ceiling textures.
+ * @pool: The worker pool casting the floor and ceiling rows.
+ * @map: The grid of the maze layout with walls.
+ * @cols: The rays of every screen column, already cast by cast_frame.
+ *
+ * Description: The floor and ceiling fill every row first, then the walls
+ * are drawn over them, and the sprites over the walls.
+ **/
+void draw_frame_soft(Uint32 *pixels, const atlas *tex, worker_pool *pool,
+		     grid *map, columns *cols)
+{
+	uint64_t start = trace_begin();
+
+	cast_floor(pool, pixels, tex, cols);
+	trace_end(TRACE_FLOOR, start);
+	start = trace_begin();
+	draw_walls_soft(pixels, tex, map, cols);
+	trace_end(TRACE_WALLS, start);
+	start = trace_begin();
+	draw_sprites(pixels, tex, pool, map, cols);
+	trace_end(TRACE_SPRITES, start);
+}
+
+/**
+ * draw_walls_soft - Draw the textured walls into the software framebuffer.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels.
+ * @tex: The wall textures.
+ * @map: The grid of the maze layout with walls.
+ * @cols: The distance, hit cell, side and hit offset of every screen column.
+ *
+ * Description: Works out the slice of every column first: its rows, the
+ * texture column it shows and, in 16.16 fixed point, the texture row of its
+ * first pixel and the texture rows per screen row, once per column. The
+ * slices are then written by fill_walls.
+ **/
+void draw_walls_soft(Uint32 *pixels, const atlas *tex, grid *map,
+		     columns *cols)
+{
+	int wall_start[SCREEN_WIDTH], wall_end[SCREEN_WIDTH];
+	const Uint32 *texel[SCREEN_WIDTH];
+	Uint32 tex_pos[SCREEN_WIDTH], tex_step[SCREEN_WIDTH];
+	int_s cell;
+	int screen_x, height, u;
+
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		cell = cols->cell[screen_x];
+		height = wall_height(cols->dist[screen_x]);
+		wall_slice(cols->dist[screen_x], &wall_start[screen_x],
+			   &wall_end[screen_x]);
+		u = (int)(cols->hit[screen_x] * TEX_SIZE) & (TEX_SIZE - 1);
+		texel[screen_x] = tex->texels[wall_type(grid_cell(map, cell.x, cell.y),
+						       cols->side[screen_x])] +
+			u * TEX_SIZE;
+		/* wall_slice spans height / 2 rows either side of the horizon */
+		tex_step[screen_x] = ((Uint32)TEX_SIZE << FIX_SHIFT) /
+			(height / 2 * 2 + 1);
+		/* Rows of a slice taller than the screen start inside the texture */
+		tex_pos[screen_x] = (wall_start[screen_x] -
+				     (SCREEN_HEIGHT / 2 - height / 2)) *
+			tex_step[screen_x];
+	}
+	fill_walls(pixels, wall_start, wall_end, texel, tex_pos, tex_step);
+}
+
+/**
+ * fill_walls - Write the wall slice of each column into the frame.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels, with
+ * the floor and ceiling already drawn.
+ * @wall_start: First row of the wall slice of every column.
+ * @wall_end: Last row (inclusive) of the wall slice of every column.
+ * @texel: The texture column of the wall slice of every column.
+ * @tex_pos: The texture row of the first pixel of every slice, in 16.16.
+ * @tex_step: The texture rows per screen row of every slice, in 16.16.
+ *
+ * Description: A strip of STRIP_COLS columns is drawn at a time: each
+ * slice is written top to bottom into a column-major strip that stays in
+ * L1 cache, reading its texture column front to back, and the rows the
+ * strip's slices cover are then merged into the framebuffer row by row,
+ * with a branchless select that keeps the floor and ceiling around the
+ * slices. Writing the framebuffer a column at a time instead strides a
+ * full row between pixels, and writing it a row at a time jumps between a
+ * different texture column for every pixel; both are about twice as slow.
+ **/
+void fill_walls(Uint32 *restrict pixels, const int *restrict wall_start,
+		const int *restrict wall_end,
+		const Uint32 *const *restrict texel,
+		const Uint32 *restrict tex_pos, const Uint32 *restrict tex_step)
+{
+	Uint32 strip[STRIP_COLS][SCREEN_HEIGHT];
+	const Uint32 *restrict from;
+	Uint32 *restrict to;
+	Uint32 pos, mask;
+	int left, x, y, top, bottom;
+
+	for (left = 0; left < SCREEN_WIDTH; left += STRIP_COLS)
+	{
+		top = SCREEN_HEIGHT;
+		bottom = -1;
+		for (x = 0; x < STRIP_COLS; x++)
+		{
+			to = strip[x];
+			from = texel[left + x];
+			pos = tex_pos[left + x];
+			for (y = wall_start[left + x]; y <= wall_end[left + x];
+			     y++, pos += tex_step[left + x])
+				to[y] = from[(pos >> FIX_SHIFT) & (TEX_SIZE - 1)];
+			top = wall_start[left + x] < top ? wall_start[left + x] : top;
+			bottom = wall_end[left + x] > bottom ? wall_end[left + x] :
+				bottom;
+		}
+		for (y = top; y <= bottom; y++)
+			for (x = 0; x < STRIP_COLS; x++)
+			{
+				/* All ones when y lies within the slice of the column */
+				mask = -(Uint32)((Uint32)(y - wall_start[left + x]) <=
+						 (Uint32)(wall_end[left + x] -
+							  wall_start[left + x]));
+				to = &pixels[y * SCREEN_WIDTH + left + x];
+				*to = (strip[x][y] & mask) | (*to & ~mask);
+			}
+	}
+}
+
+/**
+ * wall_height - Compute the height of a wall slice on screen.
+ * @wall_dist: Perpendicular distance from the player to the wall.
+ *
+ * Return: The height in rows, at least 1 and at most 4 * SCREEN_HEIGHT.
+ *
+ * Description: The height is inversely proportional to the distance. A
+ * player standing right against a wall can get a distance of (minus) zero,
+ * so the height is capped before converting it to an int.
+ **/
+int wall_height(double wall_dist)
+{
+	double height = SCREEN_HEIGHT / wall_dist;
+
+	if (!(height >= 0 && height < 4 * SCREEN_HEIGHT))
+		return (4 * SCREEN_HEIGHT);
+	return (height < 1 ? 1 : (int)height);
+}
+
+/**
+ * wall_slice - Compute the rows covered by a wall slice.
+ * @wall_dist: Perpendicular distance from the player to the wall.
+ * @wall_start: Output for the first row of the slice.
+ * @wall_end: Output for the last row of the slice (inclusive).
+ *
+ * Description: The slice is wall_height rows high, centered on the horizon
+ * and clamped to the screen.
+ **/
+void wall_slice(double wall_dist, int *wall_start, int *wall_end)
+{
+	int height = wall_height(wall_dist);
+
+	*wall_start = -height / 2 + SCREEN_HEIGHT / 2;
+	if (*wall_start < 0)
+		*wall_start = 0;
+	*wall_end = height / 2 + SCREEN_HEIGHT / 2;
+	if (*wall_end >= SCREEN_HEIGHT)
+		*wall_end = SCREEN_HEIGHT - 1;
+}
@@ -0,0 +1,179 @@
+#include "../maze.h"
+
+/**
+ * draw_sprites - Draw the entities in view over the frame.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels, with
+ * the walls, floor and ceiling already drawn.
+ * @tex: The sprite textures.
+ * @pool: The worker pool to spread the columns over, or NULL.
+ * @map: The grid holding the entities of the level.
+ * @cols: The rays of every screen column, already cast by cast_frame.
+ *
+ * Description: The wall distance of every column, cols->dist, is the depth
+ * buffer of the frame. The entities in view are projected once, then the
+ * screen columns are shared out among the threads, each drawing every
+ * sprite clipped to its own columns, so no two threads write a pixel.
+ **/
+void draw_sprites(Uint32 *pixels, const atlas *tex, worker_pool *pool,
+		  grid *map, columns *cols)
+{
+	sprite_job job;
+
+	if (map->ents == NULL)
+		return;
+	job.seen = sprite_view(map->ents, cols);
+	if (job.seen == 0)
+		return;
+	job.pixels = pixels;
+	job.tex = tex;
+	job.ents = map->ents;
+	job.cols = cols;
+	pool_run(pool, sprite_range, &job, SCREEN_WIDTH, COLUMN_GRAIN);
+}
+
+/**
+ * sprite_view - Project the entities in view onto the screen.
+ * @ents: The entities of the level; the ones in view are written to
+ * ents->seen.
+ * @cols: The rays of the frame, for the pose they were cast from.
+ *
+ * Return: The number of entities in view.
+ *
+ * Description: An entity is culled, before working out anything else
+ * about it, when it is behind the player or further than the furthest
+ * wall of the frame, which in a maze leaves few; then when it is outside
+ * the view frustum. The others are sorted nearest first.
+ **/
+int sprite_view(entities *ents, columns *cols)
+{
+	double_s dir, plane;
+	double far = 0, det, dx, dy, depth, cam, half;
+	sprite *s;
+	int i, seen = 0;
+
+	view_vectors(cols->angle, &dir, &plane);
+	det = dir.x * plane.y - dir.y * plane.x;
+	for (i = 0; i < SCREEN_WIDTH; i++)
+		far = cols->dist[i] > far ? cols->dist[i] : far;
+	for (i = 0; i < ents->count; i++)
+	{
+		dx = ents->x[i] - cols->play.x;
+		dy = ents->y[i] - cols->play.y;
+		depth = (dx * plane.y - dy * plane.x) / det;
+		if (!(depth >= SPRITE_NEAR && depth < far))
+			continue;
+		/* Camera x of the center, and half a cell in camera x */
+		cam = (dir.x * dy - dir.y * dx) / det / depth;
+		half = 0.5 / (VIEW_PLANE * depth);
+		if (fabs(cam) - half >= 1)
+			continue;
+		s = &ents->seen[seen++];
+		s->depth = depth;
+		s->center = (int)(SCREEN_WIDTH / 2 * (1 + cam));
+		s->width = (int)(SCREEN_WIDTH * half);
+		s->width = s->width < 1 ? 1 : s->width;
+		s->height = wall_height(depth);
+		s->type = ents->type[i];
+	}
+	qsort(ents->seen, seen, sizeof(sprite), cmp_sprite);
+	return (seen);
+}
+
+/**
+ * cmp_sprite - Compare two sprites by depth, for qsort.
+ * @a: Pointer to the first sprite.
+ * @b: Pointer to the second sprite.
+ *
+ * Return: Negative, zero or positive as the first is nearer, as near or
+ * further than the second.
+ **/
+int cmp_sprite(const void *a, const void *b)
+{
+	double da = ((const sprite *)a)->depth, db = ((const sprite *)b)->depth;
+
+	return ((da > db) - (da < db));
+}
+
+/**
+ * sprite_range - Draw the sprites in view on a range of screen columns.
+ * @arg: The sprite_job describing the frame.
+ * @from: The first column to draw.
+ * @to: One past the last column to draw.
+ *
+ * Description: Sprites are drawn front to back, and a pixel a nearer
+ * sprite has covered is kept, which a bit per pixel of a coverage mask
+ * tells. Only the columns of the range are cleared and used.
+ **/
+void sprite_range(void *arg, int from, int to)
+{
+	const sprite_job *job = arg;
+	uint64_t cover[SCREEN_WIDTH][COVER_WORDS];
+	const sprite *s;
+	int i;
+
+	memset(cover[from], 0, sizeof(cover[0]) * (to - from));
+	for (i = 0; i < job->seen; i++)
+	{
+		s = &job->ents->seen[i];
+		sprite_draw(job->pixels, job->tex, s, job->cols, cover, from, to);
+	}
+}
+
+/**
+ * sprite_draw - Draw a sprite, clipped by the walls and nearer sprites.
+ * @pixels: The framebuffer, SCREEN_WIDTH * SCREEN_HEIGHT ARGB pixels.
+ * @tex: The sprite textures, and their opaque spans.
+ * @s: The sprite.
+ * @cols: The rays of the frame, whose distances clip the sprite.
+ * @cover: The coverage mask, a bit per pixel, column-major; the pixels
+ * drawn are added to it.
+ * @from: The first screen column to draw.
+ * @to: One past the last screen column to draw.
+ *
+ * Description: A column of the sprite behind the wall of its screen
+ * column is skipped without reading a texel. The others read a single
+ * texture column front to back, stepping through it in 16.16 fixed point
+ * like the wall slices, over the rows of its opaque span only, and leave
+ * the transparent texels within it alone.
+ **/
+void sprite_draw(Uint32 *pixels, const atlas *tex, const sprite *s,
+		 columns *cols, uint64_t (*cover)[COVER_WORDS], int from,
+		 int to)
+{
+	const Uint32 *column;
+	const Uint8 *span;
+	Uint32 color, u, u_step, v_step, v_pos;
+	int left = s->center - s->width / 2, top = SCREEN_HEIGHT / 2 -
+		s->height / 2;
+	int x, x_end, y, y_start, y_end, y_last;
+
+	u_step = (Uint32)((double)TEX_SIZE * FIX_ONE / s->width);
+	v_step = (Uint32)((double)TEX_SIZE * FIX_ONE / s->height);
+	x = left < from ? from : left;
+	x_end = left + s->width < to ? left + s->width : to;
+	y_start = top < 0 ? 0 : top;
+	y_end = top + s->height < SCREEN_HEIGHT ? top + s->height :
+		SCREEN_HEIGHT;
+	for (; x < x_end; x++)
+	{
+		if (s->depth >= cols->dist[x])
+			continue;  /* Behind the wall of the column */
+		u = ((Uint32)(x - left) * u_step) >> FIX_SHIFT;
+		column = tex->sprites[s->type] + u * TEX_SIZE;
+		span = tex->opaque[s->type][u];
+		/* Screen rows showing the span, give or take a row */
+		y = top + span[0] * s->height / TEX_SIZE;
+		y = y < y_start ? y_start : y;
+		y_last = top + (span[1] * s->height + TEX_SIZE - 1) / TEX_SIZE;
+		y_last = y_last < y_end ? y_last : y_end;
+		v_pos = (Uint32)(y - top) * v_step;
+		for (; y < y_last; y++, v_pos += v_step)
+		{
+			color = column[v_pos >> FIX_SHIFT];
+			if ((color >> 24) == 0 || ((cover[x][y >> 6] >> (y & 63)) & 1))
+				continue;
+			pixels[y * SCREEN_WIDTH + x] = color;
+			cover[x][y >> 6] |= (uint64_t)1 << (y & 63);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include "../maze_core.h"
+
+/**
+ * entities_create - Allocate an empty set of entities.
+ *
+ * Return: The entities, or NULL if they cannot be allocated.
+ **/
+entities *entities_create(void)
+{
+	return (calloc(1, sizeof(entities)));
+}
+
+/**
+ * entity_add - Add an entity to a level.
+ * @ents: The entities of the level.
+ * @x: The row of the entity.
+ * @y: The column of the entity.
+ * @type: The entity type.
+ *
+ * Return: 0 on success, 1 if the arrays cannot be grown; the entities
+ * already added are kept.
+ *
+ * Description: Every array, the sprites in view included, doubles when
+ * full, so a level of any number of entities takes a few reallocations.
+ **/
+int entity_add(entities *ents, double x, double y, int type)
+{
+	double *grown_x, *grown_y;
+	unsigned char *grown_type;
+	sprite *grown_seen;
+	int cap;
+
+	if (ents->count == ents->cap)
+	{
+		cap = ents->cap > 0 ? ents->cap * 2 : 64;
+		grown_x = realloc(ents->x, sizeof(double) * cap);
+		if (grown_x != NULL)
+			ents->x = grown_x;
+		grown_y = realloc(ents->y, sizeof(double) * cap);
+		if (grown_y != NULL)
+			ents->y = grown_y;
+		grown_type = realloc(ents->type, cap);
+		if (grown_type != NULL)
+			ents->type = grown_type;
+		grown_seen = realloc(ents->seen, sizeof(sprite) * cap);
+		if (grown_seen != NULL)
+			ents->seen = grown_seen;
+		if (grown_x == NULL || grown_y == NULL || grown_type == NULL ||
+		    grown_seen == NULL)
+			return (1);
+		ents->cap = cap;
+	}
+	ents->x[ents->count] = x;
+	ents->y[ents->count] = y;
+	ents->type[ents->count++] = type;
+	return (0);
+}
+
+/**
+ * entities_free - Free the entities of a level.
+ * @ents: The entities, may be NULL.
+ **/
+void entities_free(entities *ents)
+{
+	if (ents == NULL)
+		return;
+	free(ents->x);
+	free(ents->y);
+	free(ents->type);
+	free(ents->seen);
+	free(ents);
+}
@@ -3,51 +3,69 @@
 /**
  * free_memory - Frees all allocated resources, including the map and SDL instance.
  * @instance: SDL_Instance containing the window and renderer.
- * @map: 2D array representing the map of the play space.
- * @map_h: The height of the map (number of rows in the 2D array).
+ * @map: The grid of the play space.
  *
  * Description: This function calls `free_map` to free the dynamically
- * allocated memory for the 2D map array, and `close_SDL` to properly
+ * allocated memory for the map grid, and `close_SDL` to properly
  * shut down the SDL instance by destroying the window and renderer.
  **/
-void free_memory(SDL_Instance instance, char **map, size_t map_h)
+void free_memory(SDL_Instance instance, grid *map)
 {
-	free_map(map, map_h);  /* Free the 2D map array */
+	free_map(map);  /* Free the map grid */
 	close_SDL(instance);   /* Close the SDL window and renderer */
 }
 
 /**
- * free_map - Frees the memory used by the map 2D array.
- * @map: 2D array representing the map of the play space.
- * @map_h: The height of the map (number of rows in the 2D array).
+ * free_map - Frees the memory used by the map grid.
+ * @map: The grid of the play space, may be NULL.
  *
- * Description: Iterates through each row of the 2D map array and frees
- * the memory allocated for each row. The number of rows is determined
- * by the value of map_h.
+ * Description: Releases the loaded chunks, the chunk directory and the
+ * row index, and unmaps the level file the chunks are read from.
  **/
-void free_map(char **map, size_t map_h)
+void free_map(grid *map)
 {
-	size_t i = 0;
-
-	/* Free each row of the 2D array */
-	while (i < map_h)
-	{
-		free(map[i]);
-		i++;
-	}
+	grid_free(map);
 }
 
 /**
  * close_SDL - Closes the SDL window and renderer.
  * @instance: SDL_Instance structure containing the SDL window and renderer.
  *
- * Description: Properly shuts down SDL by destroying the window and renderer,
- * and calling SDL_Quit() to clean up all initialized SDL subsystems.
+ * Description: Properly shuts down SDL by destroying the framebuffer texture,
+ * the window and renderer, and calling SDL_Quit() to clean up all
+ * initialized SDL subsystems.
  **/
 void close_SDL(SDL_Instance instance)
 {
+	if (instance.frame != NULL)
+		SDL_DestroyTexture(instance.frame);  /* Destroy the framebuffer texture */
+	if (instance.cache != NULL)
+		SDL_DestroyTexture(instance.cache);  /* Destroy the frame cache */
+	free(instance.pixels);                   /* Free the software framebuffer */
+	free(instance.tex);                      /* Free the wall textures */
+	free(instance.batch);                    /* Free the rectangle batches */
+	free(instance.stats);                    /* Free the draw counters */
 	SDL_DestroyRenderer(instance.renderer);  /* Destroy the SDL renderer */
 	SDL_DestroyWindow(instance.window);      /* Destroy the SDL window */
 	SDL_Quit();                              /* Clean up all SDL subsystems */
 }
 
+
+/**
+ * close_offscreen - Free an SDL instance with no window.
+ * @instance: SDL_Instance set up by init_offscreen, even if it failed.
+ *
+ * Description: Destroys the software renderer and its surface, and frees
+ * the buffers of the render path; SDL was not initialized, so it is not
+ * shut down.
+ **/
+void close_offscreen(SDL_Instance instance)
+{
+	if (instance.renderer != NULL)
+		SDL_DestroyRenderer(instance.renderer);
+	SDL_FreeSurface(instance.surface);
+	free(instance.pixels);
+	free(instance.tex);
+	free(instance.batch);
+	free(instance.stats);
+}
@@ -0,0 +1,351 @@
+#include "../maze_core.h"
+
+/**
+ * gen_create - Start generating a maze.
+ * @width: The number of columns of the map, at least 3; an even width is
+ * rounded down.
+ * @height: The number of rows of the map, at least 3; an even height is
+ * rounded down.
+ * @seed: The seed of the maze; the same seed and size give the same maze.
+ *
+ * Return: The generator, or NULL if it cannot be allocated.
+ *
+ * Description: The maze is perfect: there is exactly one path between any
+ * two of its cells. Every cell of the first row starts a set of its own.
+ **/
+maze_gen *gen_create(int width, int height, uint64_t seed)
+{
+	maze_gen *g = calloc(1, sizeof(maze_gen));
+	int i;
+
+	if (g == NULL)
+		return (NULL);
+	g->width = (width - 1) | 1;
+	g->height = (height - 1) | 1;
+	g->cells = (g->width - 1) / 2;
+	/* splitmix64 of the seed, so close seeds give unrelated mazes */
+	seed += 0x9e3779b97f4a7c15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+	g->state = (seed ^ (seed >> 31)) | 1;
+	g->set = malloc(sizeof(int) * g->cells);
+	g->parent = malloc(sizeof(int) * g->cells);
+	g->count = calloc(g->cells, sizeof(int));
+	g->linked = calloc(g->cells, 1);
+	g->down = calloc(g->cells, 1);
+	if (g->set == NULL || g->parent == NULL || g->count == NULL ||
+	    g->linked == NULL || g->down == NULL)
+	{
+		gen_free(g);
+		return (NULL);
+	}
+	for (i = 0; i < g->cells; i++)
+		g->set[i] = g->parent[i] = i;
+	return (g);
+}
+
+/**
+ * gen_bit - Draw a random bit.
+ * @g: The generator.
+ *
+ * Return: 0 or 1, as likely.
+ *
+ * Description: A xorshift64* draw gives 64 bits, used one at a time.
+ **/
+int gen_bit(maze_gen *g)
+{
+	int bit;
+
+	if (g->nbits == 0)
+	{
+		g->state ^= g->state >> 12;
+		g->state ^= g->state << 25;
+		g->state ^= g->state >> 27;
+		g->bits = g->state * 0x2545f4914f6cdd1dULL;
+		g->nbits = 64;
+	}
+	bit = g->bits & 1;
+	g->bits >>= 1;
+	g->nbits--;
+	return (bit);
+}
+
+/**
+ * gen_wall - The wall type of a map cell.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: '1' to '4', changing every 1 << GEN_WALL_SHIFT cells so the
+ * player can tell the parts of a large maze apart.
+ **/
+static inline char gen_wall(int x, int y)
+{
+	return ('1' + (((x >> GEN_WALL_SHIFT) ^ (y >> GEN_WALL_SHIFT)) & 3));
+}
+
+/**
+ * set_find - Find the set a label belongs to.
+ * @parent: The union-find parent of each label.
+ * @l: The label.
+ *
+ * Return: The label standing for the whole set.
+ **/
+static inline int set_find(int *parent, int l)
+{
+	while (parent[l] != l)
+	{
+		parent[l] = parent[parent[l]];  /* Path halving */
+		l = parent[l];
+	}
+	return (l);
+}
+
+/**
+ * gen_next - Write the next row of the map.
+ * @g: The generator.
+ * @line: Where to write the row, g->width cells, without a newline.
+ *
+ * Return: 1 if a row was written, 0 once the map is complete.
+ *
+ * Description: The first and last rows are the border. The others go in
+ * pairs, one per row of the maze: the row of its cells, and the row of the
+ * walls below them. The player starts in the top left cell and the win
+ * square is the bottom right one.
+ **/
+int gen_next(maze_gen *g, char *line)
+{
+	int i;
+
+	if (g->row >= g->height)
+		return (0);
+	if (g->row == 0 || g->row == g->height - 1)
+		for (i = 0; i < g->width; i++)
+			line[i] = gen_wall(g->row, i);
+	else if (g->row % 2 == 1)
+		gen_join(g, line);
+	else
+		gen_split(g, line);
+	if (g->row == 1)
+		line[1] = 'p';
+	if (g->row == g->height - 2)
+		line[g->width - 2] = 'w';
+	g->row++;
+	return (1);
+}
+
+/**
+ * gen_join - Join the cells of a maze row, and write them.
+ * @g: The generator, at the row of cells of a maze row.
+ * @line: Where to write the map row.
+ *
+ * Description: Two neighbouring cells of different sets are joined at
+ * random, merging the sets. In the last row they always are, which joins
+ * the whole maze. The labels are then resolved to their sets, and the
+ * cells of each set counted for the pass down.
+ **/
+void gen_join(maze_gen *g, char *line)
+{
+	int last = g->row == g->height - 2, i, a, b, join;
+
+	line[0] = gen_wall(g->row, 0);
+	a = set_find(g->parent, g->set[0]);
+	for (i = 0; i < g->cells; i++)
+	{
+		line[2 * i + 1] = '0';
+		join = 0;
+		if (i + 1 < g->cells)
+		{
+			b = set_find(g->parent, g->set[i + 1]);
+			join = a != b && (last || gen_bit(g));
+			if (join)
+				g->parent[b] = a;
+			a = join ? a : b;  /* The set of the next cell */
+		}
+		line[2 * i + 2] = join ? '0' : gen_wall(g->row, 2 * i + 2);
+	}
+	for (i = 0; i < g->cells; i++)
+	{
+		g->set[i] = set_find(g->parent, g->set[i]);
+		g->count[g->set[i]]++;
+	}
+}
+
+/**
+ * gen_split - Open cells of a maze row down to the next, and write the
+ * walls below them.
+ * @g: The generator, at the row of walls below a maze row.
+ * @line: Where to write the map row.
+ *
+ * Description: A cell opens down at random, except that the last cell of
+ * a set with none open yet always does, so no set is cut off. The cells of
+ * the next row below an opening keep its set; the others start sets of
+ * their own, under labels no cell above them kept.
+ **/
+void gen_split(maze_gen *g, char *line)
+{
+	int i, l, next = 0;
+
+	line[0] = gen_wall(g->row, 0);
+	for (i = 0; i < g->cells; i++)
+	{
+		l = g->set[i];
+		g->down[i] = gen_bit(g) | (g->count[l] == 1 && !g->linked[l]);
+		g->count[l]--;
+		g->linked[l] |= g->down[i];
+		line[2 * i + 1] = g->down[i] ? '0' : gen_wall(g->row, 2 * i + 1);
+		line[2 * i + 2] = gen_wall(g->row, 2 * i + 2);
+	}
+	/* g->linked now marks the labels still in use */
+	for (i = 0; i < g->cells; i++)
+		if (!g->down[i])
+		{
+			while (g->linked[next])
+				next++;
+			g->set[i] = next++;
+		}
+	memset(g->linked, 0, g->cells);
+	for (l = 0; l < g->cells; l++)
+		g->parent[l] = l;
+}
+
+/**
+ * gen_write_text - Write the whole maze as a text level.
+ * @g: The generator, with no row written yet.
+ * @out: The stream to write to.
+ *
+ * Return: 0 on success, 1 if writing failed.
+ **/
+int gen_write_text(maze_gen *g, FILE *out)
+{
+	char *line = malloc(g->width + 1);
+	int failed = line == NULL;
+
+	if (!failed)
+		line[g->width] = '\n';
+	while (!failed && gen_next(g, line))
+		failed = fwrite(line, 1, g->width + 1, out) != (size_t)g->width + 1;
+	free(line);
+	return (failed);
+}
+
+/**
+ * gen_band - Write the chunks of a band of CHUNK_SIZE map rows to a
+ * compiled level.
+ * @hd: The header of the level.
+ * @band: The rows of the band, hd->width cells each.
+ * @rows: The number of rows of the band, fewer than CHUNK_SIZE at the
+ * bottom of the map.
+ * @cx: The chunk row of the band.
+ * @sums: Where to put the checksum of each chunk, hd->chunk_cols of them.
+ * @out: The level file, at the first chunk of the band; it is left at
+ * the first chunk of the next band.
+ *
+ * Return: 0 on success, 1 if writing failed.
+ *
+ * Description: The chunks are built as chunk_load builds those of a text
+ * level, and their checksums written to their place in the table.
+ **/
+int gen_band(const level_header *hd, const char *band, int rows, int cx,
+	     uint64_t *sums, FILE *out)
+{
+	const char *lines[CHUNK_SIZE];
+	int lens[CHUNK_SIZE];
+	chunk c;
+	long at;
+	int i, cy;
+
+	for (cy = 0; cy < hd->chunk_cols; cy++)
+	{
+		for (i = 0; i < CHUNK_SIZE; i++)
+		{
+			lens[i] = i < rows ? hd->width - cy * CHUNK_SIZE : 0;
+			lens[i] = lens[i] > CHUNK_SIZE ? CHUNK_SIZE : lens[i];
+			lines[i] = band + (size_t)i * hd->width + cy * CHUNK_SIZE;
+		}
+		chunk_fill(&c, lines, lens);
+		c.cx = cx;
+		c.cy = cy;
+		sums[cy] = level_checksum(&c, sizeof(chunk), LEVEL_SEED);
+		if (fwrite(&c, sizeof(chunk), 1, out) != 1)
+			return (1);
+	}
+	at = ftell(out);
+	return (at < 0 ||
+		fseek(out, sizeof(*hd) + sizeof(uint64_t) * cx * hd->chunk_cols,
+		      SEEK_SET) != 0 ||
+		fwrite(sums, sizeof(uint64_t), hd->chunk_cols, out) !=
+		(size_t)hd->chunk_cols || fseek(out, at, SEEK_SET) != 0);
+}
+
+/**
+ * gen_write_level - Write the whole maze as a compiled level.
+ * @g: The generator, with no row written yet.
+ * @out: The level file, which must be seekable.
+ *
+ * Return: 0 on success, 1 if memory ran out or writing failed.
+ *
+ * Description: The same level file as mazec compiles from the text level,
+ * written a band of chunks at a time: only CHUNK_SIZE rows of the map are
+ * kept. Everything the header checksum covers is known or written in
+ * order, so it is summed as it goes, and the header written last.
+ **/
+int gen_write_level(maze_gen *g, FILE *out)
+{
+	level_header hd = {LEVEL_MAGIC, LEVEL_VERSION, sizeof(chunk), 0, 0, 0,
+			   0, START_ANGLE, 0, 0, 1, 1, 1, 0, 0};
+	double win_x = g->height - 1.5, win_y = g->width - 1.5;
+	unsigned char type = ENTITY_WIN;
+	uint64_t *sums, sum;
+	char *band;
+	int cx, rows, failed;
+
+	hd.width = g->width;
+	hd.height = g->height;
+	hd.chunk_rows = (g->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	hd.chunk_cols = (g->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	hd.win_x = g->height - 2;
+	hd.win_y = g->width - 2;
+	hd.chunks_at = sizeof(hd) + sizeof(uint64_t) * hd.chunk_rows * hd.chunk_cols;
+	hd.chunks_at = (hd.chunks_at + LEVEL_ALIGN - 1) / LEVEL_ALIGN * LEVEL_ALIGN;
+	band = malloc((size_t)CHUNK_SIZE * g->width);
+	sums = malloc(sizeof(uint64_t) * hd.chunk_cols);
+	failed = band == NULL || sums == NULL ||
+		fseek(out, hd.chunks_at, SEEK_SET) != 0;
+	sum = level_checksum(&hd, sizeof(hd), LEVEL_SEED);
+	for (cx = 0; !failed && cx < hd.chunk_rows; cx++)
+	{
+		for (rows = 0; rows < CHUNK_SIZE; rows++)
+			if (!gen_next(g, band + (size_t)rows * g->width))
+				break;
+		failed = gen_band(&hd, band, rows, cx, sums, out);
+		sum = level_checksum(sums, sizeof(uint64_t) * hd.chunk_cols, sum);
+	}
+	sum = level_checksum(&win_x, sizeof(double), sum);
+	sum = level_checksum(&win_y, sizeof(double), sum);
+	hd.checksum = level_checksum(&type, 1, sum);
+	if (!failed && (fwrite(&win_x, sizeof(double), 1, out) != 1 ||
+			fwrite(&win_y, sizeof(double), 1, out) != 1 ||
+			fwrite(&type, 1, 1, out) != 1 ||
+			fseek(out, 0, SEEK_SET) != 0 ||
+			fwrite(&hd, sizeof(hd), 1, out) != 1))
+		failed = 1;
+	free(band);
+	free(sums);
+	return (failed);
+}
+
+/**
+ * gen_free - Free a generator.
+ * @g: The generator, may be NULL.
+ **/
+void gen_free(maze_gen *g)
+{
+	if (g == NULL)
+		return;
+	free(g->set);
+	free(g->parent);
+	free(g->count);
+	free(g->linked);
+	free(g->down);
+	free(g);
+}
@@ -0,0 +1,299 @@
+#include "../maze_core.h"
+
+/**
+ * grid_create - Allocate a map grid with no chunk loaded.
+ * @width: The number of columns of the map (its longest row).
+ * @height: The number of rows of the map.
+ *
+ * Return: The grid, or NULL if it cannot be allocated.
+ *
+ * Description: Only the chunk directory, one pointer per CHUNK_SIZE x
+ * CHUNK_SIZE cells, grows with the map; the level file and its row index
+ * are attached by create_map.
+ * Every directory entry starts out pointing to the horizon chunk, which is
+ * all walls; so does the ring of entries around the map, so a ray can
+ * never leave the directory before hitting something solid.
+ **/
+grid *grid_create(int width, int height)
+{
+	grid *map;
+	size_t entries, i;
+
+	map = calloc(1, sizeof(grid));
+	if (map == NULL)
+		return (NULL);
+	map->width = width;
+	map->height = height;
+	map->dir_stride = (width + CHUNK_SIZE - 1) / CHUNK_SIZE + 2;
+	map->center.x = map->center.y = -2;
+	entries = (size_t)map->dir_stride *
+		((height + CHUNK_SIZE - 1) / CHUNK_SIZE + 2);
+	map->dir = malloc(sizeof(chunk *) * entries);
+	map->horizon = malloc(sizeof(chunk));
+	map->resident = malloc(sizeof(chunk *) * RESIDENT_MAX);
+	map->spare = malloc(sizeof(chunk *) * RESIDENT_MAX);
+	if (map->dir == NULL || map->horizon == NULL || map->resident == NULL ||
+	    map->spare == NULL)
+	{
+		grid_free(map);
+		return (NULL);
+	}
+	memset(map->horizon->solid, 0xFF, sizeof(map->horizon->solid));
+	memset(map->horizon->cells, SENTINEL_WALL, sizeof(map->horizon->cells));
+	memset(map->horizon->field, 0, sizeof(map->horizon->field));
+	map->horizon->cx = map->horizon->cy = -1;
+	for (i = 0; i < entries; i++)
+		map->dir[i] = map->horizon;
+	return (map);
+}
+
+/**
+ * chunk_load - Load a chunk of the map from the level file.
+ * @map: The grid, with its row index filled in.
+ * @cx: The chunk row.
+ * @cy: The chunk column.
+ *
+ * Return: 0 on success, 1 if the chunk cannot be allocated, in which case
+ * it is left as horizon walls.
+ *
+ * Description: The chunks of a compiled level are used in place
+ * (chunk_map). For a text level, only the part of each of the CHUNK_SIZE
+ * rows that falls in the chunk is read from the mapped file. Cells past
+ * the end of a row or of the map are sentinel walls, so ragged rows and
+ * open borders are closed off.
+ **/
+int chunk_load(grid *map, int cx, int cy)
+{
+	const char *lines[CHUNK_SIZE];
+	int lens[CHUNK_SIZE];
+	chunk *c;
+	int i, row, len;
+
+	if (map->chunks != NULL)
+		return (chunk_map(map, cx, cy));
+	if (map->spares > 0)
+		c = map->spare[--map->spares];
+	else
+		c = malloc(sizeof(chunk));
+	if (c == NULL)
+		return (1);
+	for (i = 0; i < CHUNK_SIZE; i++)
+	{
+		row = cx * CHUNK_SIZE + i;
+		len = row < map->height ? map->rows[row].len - cy * CHUNK_SIZE : 0;
+		lens[i] = len < 0 ? 0 : len > CHUNK_SIZE ? CHUNK_SIZE : len;
+		lines[i] = lens[i] > 0 ? map->text + map->rows[row].start +
+			cy * CHUNK_SIZE : NULL;
+	}
+	chunk_fill(c, lines, lens);
+	c->cx = cx;
+	c->cy = cy;
+	chunk_install(map, c, cx, cy);
+	return (0);
+}
+
+/**
+ * chunk_fill - Set the cells, wall bits and distance field of a chunk.
+ * @c: The chunk; its position is left alone.
+ * @lines: The text of each of the CHUNK_SIZE rows of the chunk, from its
+ * first column.
+ * @lens: The number of cells of each row that fall in the chunk, 0 to
+ * CHUNK_SIZE; the others are sentinel walls.
+ *
+ * Description: The player, win and entity cells are empty.
+ **/
+void chunk_fill(chunk *c, const char *const *lines, const int *lens)
+{
+	const char *line;
+	int i, j;
+
+	memset(c->solid, 0xFF, sizeof(c->solid));
+	memset(c->cells, SENTINEL_WALL, sizeof(c->cells));
+	for (i = 0; i < CHUNK_SIZE; i++)
+	{
+		line = lines[i];
+		for (j = 0; j < lens[i]; j++)
+		{
+			c->cells[i * CHUNK_SIZE + j] = line[j];
+			if (line[j] == 'p' || line[j] == 'w' || line[j] == 'k' ||
+			    line[j] == 'e')
+				c->cells[i * CHUNK_SIZE + j] = '0';
+			if (c->cells[i * CHUNK_SIZE + j] == '0')
+				c->solid[i] &= ~((uint64_t)1 << j);
+		}
+	}
+	chunk_field(c);
+}
+
+/**
+ * chunk_install - Make a loaded chunk part of the map.
+ * @map: The grid.
+ * @c: The chunk, with all its fields set.
+ * @cx: The chunk row.
+ * @cy: The chunk column.
+ **/
+void chunk_install(grid *map, chunk *c, int cx, int cy)
+{
+	map->dir[(cx + 1) * map->dir_stride + cy + 1] = c;
+	map->resident[map->count++] = c;
+}
+
+/**
+ * chunk_evict - Drop a loaded chunk from the map.
+ * @map: The grid.
+ * @i: The index of the chunk among the loaded ones; the last loaded chunk
+ * takes its place.
+ *
+ * Description: The chunk shows as horizon walls again. A chunk allocated
+ * by the grid is kept for reuse; a chunk of a compiled level file stays
+ * where it is, in the file.
+ **/
+void chunk_evict(grid *map, int i)
+{
+	chunk *c = map->resident[i];
+
+	map->dir[(c->cx + 1) * map->dir_stride + c->cy + 1] = map->horizon;
+	if (!chunk_mapped(map, c))
+		map->spare[map->spares++] = c;
+	map->resident[i] = map->resident[--map->count];
+}
+
+/**
+ * chunk_mapped - Tell whether a chunk lives in the level file mapping.
+ * @map: The grid.
+ * @c: The chunk.
+ *
+ * Return: 1 if the chunk is part of a compiled level file, 0 if the grid
+ * allocated it.
+ **/
+int chunk_mapped(grid *map, chunk *c)
+{
+	return ((const char *)c >= map->text &&
+		(const char *)c < map->text + map->size);
+}
+
+/**
+ * chunk_field - Compute the distance of every cell of a chunk to a wall.
+ * @c: The chunk, with its cells set.
+ *
+ * Description: The distance is the Chebyshev (chessboard) one, so a cell at
+ * distance d is the center of a square of empty cells of radius d - 1 that
+ * a ray can cross without looking at the map. Two raster passes, each
+ * taking the smaller of the cell and its already visited neighbours plus
+ * one, give the exact distance. Neighbours outside the chunk count as
+ * walls: the squares never leave the chunk, so the field of a chunk does
+ * not depend on which other chunks are loaded.
+ **/
+void chunk_field(chunk *c)
+{
+	uint8_t *f = c->field;
+	int r, k, d, i;
+
+	for (r = 0; r < CHUNK_SIZE; r++)
+		for (k = 0; k < CHUNK_SIZE; k++)
+			f[r * CHUNK_SIZE + k] = ((c->solid[r] >> k) & 1) ? 0 : 255;
+	for (r = 0; r < CHUNK_SIZE; r++)
+		for (k = 0; k < CHUNK_SIZE; k++)
+		{
+			i = r * CHUNK_SIZE + k;
+			if (r == 0 || k == 0 || k == CHUNK_SIZE - 1)
+				d = 0;
+			else
+			{
+				d = f[i - CHUNK_SIZE - 1] < f[i - CHUNK_SIZE] ?
+					f[i - CHUNK_SIZE - 1] : f[i - CHUNK_SIZE];
+				d = f[i - CHUNK_SIZE + 1] < d ? f[i - CHUNK_SIZE + 1] : d;
+				d = f[i - 1] < d ? f[i - 1] : d;
+			}
+			if (d + 1 < f[i])
+				f[i] = d + 1;
+		}
+	for (r = CHUNK_SIZE - 1; r >= 0; r--)
+		for (k = CHUNK_SIZE - 1; k >= 0; k--)
+		{
+			i = r * CHUNK_SIZE + k;
+			if (r == CHUNK_SIZE - 1 || k == 0 || k == CHUNK_SIZE - 1)
+				d = 0;
+			else
+			{
+				d = f[i + CHUNK_SIZE + 1] < f[i + CHUNK_SIZE] ?
+					f[i + CHUNK_SIZE + 1] : f[i + CHUNK_SIZE];
+				d = f[i + CHUNK_SIZE - 1] < d ? f[i + CHUNK_SIZE - 1] : d;
+				d = f[i + 1] < d ? f[i + 1] : d;
+			}
+			if (d + 1 < f[i])
+				f[i] = d + 1;
+		}
+}
+
+/**
+ * grid_load_around - Keep the chunks around the player loaded.
+ * @map: The grid.
+ * @play: The player's position.
+ *
+ * Return: 0 on success, 1 if a chunk could not be loaded (it then shows as
+ * horizon walls, and loading it is tried again on the next call).
+ *
+ * Description: Chunks up to RESIDENT_RADIUS chunks away from the player's
+ * are loaded; chunks more than one chunk further out are evicted. The gap
+ * keeps a player walking along a chunk border from loading and evicting
+ * the same chunks over and over, and bounds memory to RESIDENT_MAX chunks
+ * whatever the size of the map. Nothing happens until the player changes
+ * chunk. Must not run while rays are being cast.
+ **/
+int grid_load_around(grid *map, double_s play)
+{
+	int cx = (int)play.x >> CHUNK_SHIFT, cy = (int)play.y >> CHUNK_SHIFT;
+	int rows = (map->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	int cols = map->dir_stride - 2, failed = 0, i, x, y;
+	chunk *c;
+
+	if (cx == map->center.x && cy == map->center.y)
+		return (0);
+	for (i = 0; i < map->count; i++)
+	{
+		c = map->resident[i];
+		if (abs(c->cx - cx) <= RESIDENT_RADIUS + 1 &&
+		    abs(c->cy - cy) <= RESIDENT_RADIUS + 1)
+			continue;
+		chunk_evict(map, i--);
+	}
+	for (x = cx - RESIDENT_RADIUS; x <= cx + RESIDENT_RADIUS; x++)
+		for (y = cy - RESIDENT_RADIUS; y <= cy + RESIDENT_RADIUS; y++)
+			if (x >= 0 && x < rows && y >= 0 && y < cols &&
+			    map->dir[(x + 1) * map->dir_stride + y + 1] ==
+			    map->horizon)
+				failed |= chunk_load(map, x, y);
+	if (!failed)
+	{
+		map->center.x = cx;
+		map->center.y = cy;
+	}
+	return (failed);
+}
+
+/**
+ * grid_free - Free a grid and unmap its level file.
+ * @map: The grid, may be NULL.
+ **/
+void grid_free(grid *map)
+{
+	int i;
+
+	if (map == NULL)
+		return;
+	for (i = 0; map->resident != NULL && i < map->count; i++)
+		if (!chunk_mapped(map, map->resident[i]))
+			free(map->resident[i]);
+	for (i = 0; map->spare != NULL && i < map->spares; i++)
+		free(map->spare[i]);
+	if (map->text != NULL)
+		munmap((void *)map->text, map->size);
+	free(map->dir);
+	free(map->horizon);
+	free(map->resident);
+	free(map->spare);
+	free(map->rows);
+	entities_free(map->ents);
+	free(map);
+}
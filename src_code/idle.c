@@ -0,0 +1,133 @@
+#include "../maze.h"
+
+/**
+ * cpu_ns - Read the CPU time used by the game so far.
+ *
+ * Return: User and system time of every thread, in nanoseconds.
+ **/
+double cpu_ns(void)
+{
+	struct rusage use;
+
+	getrusage(RUSAGE_SELF, &use);
+	return ((use.ru_utime.tv_sec + use.ru_stime.tv_sec) * 1e9 +
+		(use.ru_utime.tv_usec + use.ru_stime.tv_usec) * 1e3);
+}
+
+/**
+ * energy_joules - Read the energy counter of the CPU package.
+ *
+ * Return: The energy used by the package since boot, in joules, or -1 if
+ * the counter cannot be read (not an Intel RAPL machine, or not allowed).
+ *
+ * Description: The counter is for the whole package, so it includes
+ * everything else running on the machine.
+ **/
+double energy_joules(void)
+{
+	FILE *counter = fopen(ENERGY_FILE, "r");
+	double microjoules = -1e6;
+
+	if (counter == NULL)
+		return (-1);
+	if (fscanf(counter, "%lf", &microjoules) != 1)
+		microjoules = -1e6;
+	fclose(counter);
+	return (microjoules / 1e6);
+}
+
+/**
+ * idle_init - Start tracking what is on screen and the time spent idle.
+ * @idle: The idle statistics; nothing has been drawn yet.
+ **/
+void idle_init(idle_stats *idle)
+{
+	memset(idle, 0, sizeof(*idle));
+	idle->start = now_ns();
+	idle->cpu = cpu_ns();
+	idle->energy = energy_joules();
+}
+
+/**
+ * frame_unchanged - Tell whether the next frame would be the one on screen.
+ * @idle: The idle statistics, holding the pose of the frame on screen.
+ * @view: The level and player pose of the next frame.
+ * @key_press: The keys held.
+ *
+ * Return: 1 if no key is held and the level and pose are those of the
+ * frame on screen, 0 if the frame must be drawn.
+ *
+ * Description: The map only changes when the player moves into another
+ * chunk, so the same level and pose cast exactly the same rays. With a
+ * key held the next tick may move the player, so the game is not idle.
+ **/
+int frame_unchanged(idle_stats *idle, level *view, keys key_press)
+{
+	level *drawn = &idle->drawn;
+
+	if (!idle->valid || key_press.up || key_press.down || key_press.left ||
+	    key_press.right)
+		return (0);
+	return (view->map == drawn->map && view->angle == drawn->angle &&
+		view->play.x == drawn->play.x && view->play.y == drawn->play.y &&
+		view->win.x == drawn->win.x && view->win.y == drawn->win.y);
+}
+
+/**
+ * frame_drawn - Record the frame put on screen.
+ * @idle: The idle statistics.
+ * @view: The level and player pose of the frame.
+ **/
+void frame_drawn(idle_stats *idle, level *view)
+{
+	idle->drawn = *view;
+	idle->valid = 1;
+}
+
+/**
+ * idle_wait - Sleep until an event arrives or IDLE_WAIT_MS have passed.
+ * @idle: The idle statistics, updated with the time, CPU time and energy
+ * spent asleep.
+ *
+ * Description: The event is left in the queue for keyboard_events. Nothing
+ * runs in the meantime: the worker threads are asleep too, waiting for the
+ * next frame.
+ **/
+void idle_wait(idle_stats *idle)
+{
+	double start = now_ns(), cpu = cpu_ns(), energy = energy_joules(), used;
+
+	SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+	idle->idle += now_ns() - start;
+	idle->idle_cpu += cpu_ns() - cpu;
+	used = energy_joules() - energy;
+	if (energy >= 0 && used >= 0)  /* The counter may wrap around */
+		idle->idle_energy += used;
+}
+
+/**
+ * idle_report - Print the time spent idle and what it cost.
+ * @idle: The idle statistics of the game loop.
+ *
+ * Description: CPU use is CPU time over wall time, so 100% is one core
+ * busy. Power is only reported where the CPU package energy counter can be
+ * read, and it includes the rest of the machine's load.
+ **/
+void idle_report(idle_stats *idle)
+{
+	double total = now_ns() - idle->start, cpu = cpu_ns() - idle->cpu;
+	double energy = energy_joules() - idle->energy;
+	double busy = total - idle->idle;
+
+	printf("idle %.1f s of %.1f s: %.1f%% CPU idle, %.1f%% CPU playing",
+	       idle->idle / 1e9, total / 1e9,
+	       idle->idle > 0 ? 100 * idle->idle_cpu / idle->idle : 0,
+	       busy > 0 ? 100 * (cpu - idle->idle_cpu) / busy : 0);
+	if (idle->energy >= 0 && energy >= idle->idle_energy && idle->idle > 0 &&
+	    busy > 0)
+		printf(", %.2f W idle, %.2f W playing\n",
+		       idle->idle_energy / (idle->idle / 1e9),
+		       (energy - idle->idle_energy) / (busy / 1e9));
+	else
+		printf(", power not available\n");
+}
@@ -3,16 +3,31 @@
 /**
  * init_instance - Initialize an SDL instance with a window and renderer.
  * @instance: The SDL_Instance to initialize.
+ * @mode: The render path to use (RENDER_LINES, RENDER_SOFT or RENDER_BATCH).
+ * @vsync: Whether to wait for vertical sync when presenting a frame.
  * 
  * Return: 1 if initialization fails, 0 on success.
  * 
  * Description: This function sets up an SDL window and renderer for the game. 
  * It initializes the SDL video subsystem, creates a centered window titled 
  * "MAZE" with specified width and height, and sets up an accelerated renderer 
- * with vertical sync. If any step fails, it cleans up and returns an error code.
+ * with vertical sync unless the frame rate is capped or left free. If any
+ * step fails, it cleans up and returns an error code.
+ * The software render path additionally gets its framebuffer, its texture
+ * and the wall textures, and the batched one its rectangle batches.
  **/
-int init_instance(SDL_Instance *instance)
+int init_instance(SDL_Instance *instance, int mode, int vsync)
 {
+	instance->surface = NULL;
+	instance->frame = NULL;
+	instance->cache = NULL;
+	instance->pixels = NULL;
+	instance->tex = NULL;
+	instance->batch = NULL;
+	instance->mode = mode;
+	instance->cost = NULL;
+	instance->stats = NULL;
+
 	/* Initialize SDL video subsystem */
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		printf("SDL_Init Error: %s\n", SDL_GetError());
@@ -33,7 +48,7 @@ int init_instance(SDL_Instance *instance)
 	/* Create a renderer with hardware acceleration and vertical sync */
 	instance->renderer = SDL_CreateRenderer(instance->window, -1,
 						SDL_RENDERER_ACCELERATED |
-						SDL_RENDERER_PRESENTVSYNC);
+						(vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 	if (instance->renderer == NULL)
 	{
 		/* Destroy the window and quit SDL if renderer creation fails */
@@ -41,8 +56,137 @@ int init_instance(SDL_Instance *instance)
 		SDL_Quit();
 		return (1);
 	}
-	
+
+	/* Count the draw calls of every render path */
+	instance->stats = calloc(1, sizeof(draw_stats));
+	if (instance->stats == NULL)
+	{
+		close_SDL(*instance);
+		return (1);
+	}
+
+	/* The software path renders textured walls into its own framebuffer */
+	if (mode == RENDER_SOFT && init_frame(instance) != 0)
+	{
+		close_SDL(*instance);
+		return (1);
+	}
+
+	/* The batched path sorts the frame into batches of rectangles */
+	if (mode == RENDER_BATCH)
+	{
+		instance->batch = malloc(sizeof(batch));
+		if (instance->batch == NULL)
+		{
+			close_SDL(*instance);
+			return (1);
+		}
+	}
+
+	/* The line and batched paths draw into a texture kept to present the
+	 * frame again
+	 */
+	if (mode == RENDER_LINES || mode == RENDER_BATCH)
+		init_cache(instance);
+
 	/* Return 0 on successful initialization */
 	return (0);
 }
 
+/**
+ * init_cache - Create the render target the line path draws into.
+ * @instance: The SDL_Instance whose renderer the texture belongs to.
+ *
+ * Description: The frame is drawn into the texture, then copied to the
+ * window, so the last frame can be presented again without drawing it.
+ * Without render target support the cache stays NULL and the line path
+ * draws straight to the window as before.
+ **/
+void init_cache(SDL_Instance *instance)
+{
+	if (!SDL_RenderTargetSupported(instance->renderer))
+		return;
+	instance->cache = SDL_CreateTexture(instance->renderer,
+					    SDL_PIXELFORMAT_ARGB8888,
+					    SDL_TEXTUREACCESS_TARGET,
+					    SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+/**
+ * init_frame - Create the software framebuffer and its streaming texture.
+ * @instance: The SDL_Instance whose renderer the texture belongs to.
+ *
+ * Return: 1 if the texture, the framebuffer or the wall textures cannot be
+ * created, 0 on success.
+ *
+ * Description: The framebuffer is one contiguous block of ARGB8888 pixels,
+ * uploaded once per frame to a texture created with streaming access. The
+ * wall textures are loaded from TEX_DIR.
+ **/
+int init_frame(SDL_Instance *instance)
+{
+	instance->frame = SDL_CreateTexture(instance->renderer,
+					    SDL_PIXELFORMAT_ARGB8888,
+					    SDL_TEXTUREACCESS_STREAMING,
+					    SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (instance->frame == NULL)
+	{
+		printf("SDL_CreateTexture Error: %s\n", SDL_GetError());
+		return (1);
+	}
+	instance->pixels = malloc(sizeof(Uint32) * SCREEN_WIDTH * SCREEN_HEIGHT);
+	if (instance->pixels == NULL)
+		return (1);
+	instance->tex = atlas_load(TEX_DIR);
+	if (instance->tex == NULL)
+		return (1);
+	return (0);
+}
+
+
+/**
+ * init_offscreen - Initialize an SDL instance with no window, to benchmark.
+ * @instance: The SDL_Instance to initialize.
+ * @mode: The render path to use (RENDER_LINES, RENDER_SOFT or RENDER_BATCH).
+ *
+ * Return: 1 if anything cannot be created, 0 on success; close the
+ * instance with close_offscreen either way.
+ *
+ * Description: SDL is not initialized and no window is opened. The
+ * software path gets its framebuffer and textures, which it draws into
+ * without uploading them. The line and batched paths get a software
+ * renderer drawing into an offscreen surface, so their draw calls are
+ * carried out on the CPU, and the batched one its rectangle batches.
+ **/
+int init_offscreen(SDL_Instance *instance, int mode)
+{
+	memset(instance, 0, sizeof(SDL_Instance));
+	instance->mode = mode;
+	instance->stats = calloc(1, sizeof(draw_stats));
+	if (instance->stats == NULL)
+		return (1);
+	if (mode == RENDER_SOFT)
+	{
+		instance->pixels = malloc(sizeof(Uint32) * SCREEN_WIDTH *
+					  SCREEN_HEIGHT);
+		instance->tex = atlas_load(TEX_DIR);
+		return (instance->pixels == NULL || instance->tex == NULL);
+	}
+	instance->surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH,
+							   SCREEN_HEIGHT, 32,
+							   SDL_PIXELFORMAT_ARGB8888);
+	if (instance->surface != NULL)
+		instance->renderer = SDL_CreateSoftwareRenderer(instance->surface);
+	if (instance->renderer == NULL)
+	{
+		printf("SDL_CreateSoftwareRenderer Error: %s\n", SDL_GetError());
+		return (1);
+	}
+	if (mode == RENDER_BATCH)
+	{
+		instance->batch = malloc(sizeof(batch));
+		if (instance->batch == NULL)
+			return (1);
+	}
+	return (0);
+}
@@ -44,6 +44,10 @@ int check_key_press_events(SDL_Event event, keys *key_press)
 {
 	if (event.key.keysym.scancode == 0x29)  // Escape key code
 		return (1);  // Return 1 to signal program exit
+	if (event.key.keysym.scancode == 0x45)  // F12 key code
+		trace_dump();  // Write the trace so far, if tracing
+	if (event.key.keysym.scancode == 0x0B)  // H key code
+		cost_toggle();  // Show or hide the ray cost overlay
 	
 	switch (event.key.keysym.sym)
 	{
@@ -68,6 +72,9 @@ int check_key_press_events(SDL_Event event, keys *key_press)
 /**
  * keyboard_events - Process all keyboard input events.
  * @key_press: Pointer to a struct that tracks the state of up/down/left/right key presses.
+ * @exposed: Set to 1 on any window event, as the window may need the
+ * frame presented again (it was uncovered, resized or restored), and on
+ * any key press, which may show or hide the ray cost overlay.
  * 
  * Return: 0 for standard events, 1 if the quit event or ESC is detected.
  * 
@@ -75,7 +82,7 @@ int check_key_press_events(SDL_Event event, keys *key_press)
  * updating the state of the significant directional keys in key_press. If the quit event
  * (closing the window or pressing ESC) is detected, it returns 1 to signal program termination.
  **/
-int keyboard_events(keys *key_press)
+int keyboard_events(keys *key_press, int *exposed)
 {
 	SDL_Event event;
 
@@ -89,10 +96,14 @@ int keyboard_events(keys *key_press)
 		case SDL_KEYDOWN:
 			if (check_key_press_events(event, key_press))
 				return (1);  // Signal exit if ESC is pressed
+			*exposed = 1;  // The overlay may have been toggled
 			break;
 		case SDL_KEYUP:
 			check_key_release_events(event, key_press);  // Handle key release
 			break;
+		case SDL_WINDOWEVENT:
+			*exposed = 1;  // Present the frame again, even when idle
+			break;
 		default:
 			break;
 		}
@@ -0,0 +1,290 @@
+#include "../maze_core.h"
+
+/**
+ * level_checksum - Checksum a block of a compiled level file.
+ * @data: The block.
+ * @size: The size of the block in bytes.
+ * @sum: The checksum so far, LEVEL_SEED for the first block.
+ *
+ * Return: The checksum with the block added.
+ *
+ * Description: FNV-1a over 64-bit words instead of bytes, so a whole
+ * chunk is checked in about a microsecond; the last bytes of a block that
+ * is not a multiple of 8 bytes long are added one at a time.
+ **/
+uint64_t level_checksum(const void *data, size_t size, uint64_t sum)
+{
+	const unsigned char *bytes = data;
+	uint64_t word;
+	size_t i;
+
+	for (i = 0; i + sizeof(word) <= size; i += sizeof(word))
+	{
+		memcpy(&word, bytes + i, sizeof(word));
+		sum = (sum ^ word) * 0x100000001b3ULL;
+		sum ^= sum >> 29;
+	}
+	for (; i < size; i++)
+		sum = (sum ^ bytes[i]) * 0x100000001b3ULL;
+	return (sum);
+}
+
+/**
+ * check_header - Check the header of a compiled level file.
+ * @lt: The level file, mapped in memory.
+ * @hd: Its header.
+ *
+ * Return: 0 if the header is sound, 1 if not; the error has been reported.
+ *
+ * Description: Only the header, the table of chunk checksums and the
+ * entities are read, so this takes the same time whatever the size of the
+ * map. Each chunk is checked against its checksum when it is first loaded
+ * (chunk_map).
+ **/
+int check_header(level_text *lt, const level_header *hd)
+{
+	level_header copy = *hd;
+	size_t chunks, table, ents_at;
+
+	if (hd->version != LEVEL_VERSION || hd->chunk_bytes != sizeof(chunk))
+	{
+		level_error(lt, 0, 0, "compiled by another version of the game, "
+			    "compile it again with mazec");
+		return (1);
+	}
+	chunks = (size_t)hd->chunk_rows * hd->chunk_cols;
+	table = sizeof(level_header) + chunks * sizeof(uint64_t);
+	ents_at = hd->chunks_at + chunks * sizeof(chunk);
+	if (hd->width <= 0 || hd->width >= MAP_MAX || hd->height <= 0 ||
+	    hd->height >= MAP_MAX ||
+	    hd->chunk_rows != (hd->height + CHUNK_SIZE - 1) / CHUNK_SIZE ||
+	    hd->chunk_cols != (hd->width + CHUNK_SIZE - 1) / CHUNK_SIZE ||
+	    hd->chunks_at < table || hd->chunks_at % LEVEL_ALIGN != 0 ||
+	    hd->chunks_at > lt->size ||
+	    (lt->size - hd->chunks_at) / sizeof(chunk) < chunks ||
+	    hd->entities < 0 ||
+	    (lt->size - ents_at) / ENTITY_BYTES < (size_t)hd->entities)
+	{
+		level_error(lt, 0, 0, "truncated or corrupt level header");
+		return (1);
+	}
+	copy.checksum = 0;
+	if (level_checksum(lt->text + ents_at, hd->entities * ENTITY_BYTES,
+			   level_checksum(lt->text + sizeof(level_header),
+					  table - sizeof(level_header),
+					  level_checksum(&copy, sizeof(copy),
+							 LEVEL_SEED))) !=
+	    hd->checksum)
+	{
+		level_error(lt, 0, 0, "level header checksum mismatch");
+		return (1);
+	}
+	if (!(hd->play_x >= 0 && hd->play_x < hd->height && hd->play_y >= 0 &&
+	      hd->play_y < hd->width) || hd->win_x < 0 ||
+	    hd->win_x >= hd->height || hd->win_y < 0 || hd->win_y >= hd->width)
+	{
+		level_error(lt, 0, 0, "player start or win square off the map");
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * compiled_entities - Read the entities of a compiled level.
+ * @lt: The level file, mapped in memory, with its header checked.
+ * @hd: Its header.
+ *
+ * Return: 0 on success, 1 if an entity is off the map or of an unknown
+ * type, or there is no memory left for them; the error has been reported.
+ *
+ * Description: Unlike the chunks, the entities are copied out of the
+ * file, so they are held the same way as those of a text level.
+ **/
+int compiled_entities(level_text *lt, const level_header *hd)
+{
+	const char *at = lt->text + hd->chunks_at +
+		(size_t)hd->chunk_rows * hd->chunk_cols * sizeof(chunk);
+	size_t count = hd->entities;
+	double x, y;
+	int type;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		memcpy(&x, at + i * sizeof(double), sizeof(double));
+		memcpy(&y, at + (count + i) * sizeof(double), sizeof(double));
+		type = (unsigned char)at[2 * count * sizeof(double) + i];
+		if (!(x >= 0 && x < hd->height && y >= 0 && y < hd->width) ||
+		    type >= ENTITY_TYPES)
+		{
+			level_error(lt, 0, 0, "entity %zu off the map or of unknown "
+				    "type %d", i, type);
+			return (1);
+		}
+		if (entity_add(lt->ents, x, y, type) != 0)
+		{
+			level_error(lt, 0, 0, "out of memory");
+			return (1);
+		}
+	}
+	return (0);
+}
+
+/**
+ * compiled_map - Creates the grid of a level compiled by mazec.
+ * @lt: The level file, mapped in memory.
+ * @play: Output for the player's start position.
+ * @win: Output for the win square.
+ * @angle: Output for the player's start view angle.
+ * Return: The grid, without any chunk loaded, or NULL if it fails.
+ *
+ * Description: Nothing is parsed, and only the entities are copied: the
+ * grid points at the chunks in the mapping, and they are paged in from the
+ * file as they are loaded.
+ **/
+grid *compiled_map(level_text *lt, double_s *play, int_s *win, int *angle)
+{
+	const level_header *hd = (const level_header *)lt->text;
+	grid *maze;
+
+	if (check_header(lt, hd) != 0 || compiled_entities(lt, hd) != 0)
+		return (NULL);
+	maze = grid_create(hd->width, hd->height);
+	if (maze == NULL)
+		return (NULL);
+	maze->ents = lt->ents;
+	lt->ents = NULL;
+	madvise((void *)lt->text, lt->size, MADV_RANDOM);  /* A chunk at a time */
+	maze->sums = (const uint64_t *)(lt->text + sizeof(level_header));
+	maze->chunks = (const chunk *)(lt->text + hd->chunks_at);
+	play->x = hd->play_x;
+	play->y = hd->play_y;
+	win->x = hd->win_x;
+	win->y = hd->win_y;
+	*angle = hd->angle & (ANGLE_STEPS - 1);
+	return (maze);
+}
+
+/**
+ * chunk_map - Load a chunk of a compiled level.
+ * @map: The grid of a compiled level.
+ * @cx: The chunk row.
+ * @cy: The chunk column.
+ *
+ * Return: 0 on success, 1 if a corrupt chunk cannot be replaced, in which
+ * case it is left as horizon walls.
+ *
+ * Description: The chunk is used where it is in the file mapping, after
+ * checking it against its checksum. A corrupt chunk is reported and
+ * replaced by a chunk of walls, so the level stays playable around it.
+ **/
+int chunk_map(grid *map, int cx, int cy)
+{
+	size_t i = (size_t)cx * (map->dir_stride - 2) + cy;
+	const chunk *mapped = &map->chunks[i];
+	chunk *c;
+
+	if (level_checksum(mapped, sizeof(chunk), LEVEL_SEED) == map->sums[i] &&
+	    mapped->cx == cx && mapped->cy == cy)
+	{
+		chunk_install(map, (chunk *)mapped, cx, cy);
+		return (0);
+	}
+	fprintf(stderr, "chunk (%d, %d) of the level file is corrupt, "
+		"it is left as walls\n", cx, cy);
+	c = map->spares > 0 ? map->spare[--map->spares] : malloc(sizeof(chunk));
+	if (c == NULL)
+		return (1);
+	*c = *map->horizon;
+	c->cx = cx;
+	c->cy = cy;
+	chunk_install(map, c, cx, cy);
+	return (0);
+}
+
+/**
+ * compile_level - Compile a text level into a level file used in place.
+ * @file: The path of the text level.
+ * @out: The path of the compiled level to write.
+ *
+ * Return: 0 on success, 1 on failure; the error has been reported.
+ *
+ * Description: The level is loaded as the game loads it, then every chunk
+ * is loaded, with its distance field, written out and dropped in turn, so
+ * compiling takes as little memory as playing. The entities, win marker
+ * included, follow the chunks.
+ **/
+int compile_level(char *file, char *out)
+{
+	level_header hd = {LEVEL_MAGIC, LEVEL_VERSION, sizeof(chunk), 0, 0, 0,
+			   0, START_ANGLE, 0, 0, 0, 0, 0, 0, 0};
+	double_s play;
+	int_s win;
+	grid *map;
+	entities *ents;
+	uint64_t *sums, sum;
+	FILE *dst;
+	int cx, cy, failed = 0;
+	size_t i = 0, n;
+
+	map = create_map(file, &play, &win, &hd.angle);
+	if (map == NULL)
+		return (1);
+	ents = map->ents;
+	n = ents->count;
+	hd.entities = ents->count;
+	hd.width = map->width;
+	hd.height = map->height;
+	hd.chunk_rows = (map->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	hd.chunk_cols = map->dir_stride - 2;
+	hd.win_x = win.x;
+	hd.win_y = win.y;
+	hd.play_x = play.x;
+	hd.play_y = play.y;
+	hd.chunks_at = sizeof(hd) + sizeof(uint64_t) * hd.chunk_rows * hd.chunk_cols;
+	hd.chunks_at = (hd.chunks_at + LEVEL_ALIGN - 1) / LEVEL_ALIGN * LEVEL_ALIGN;
+	sums = malloc(sizeof(uint64_t) * hd.chunk_rows * hd.chunk_cols);
+	dst = fopen(out, "wb");
+	if (sums == NULL || dst == NULL || fseek(dst, hd.chunks_at, SEEK_SET) != 0)
+		failed = 1;
+	while (map->count > 0)
+		chunk_evict(map, 0);  /* Every chunk is loaded in order below */
+	for (cx = 0; !failed && cx < hd.chunk_rows; cx++)
+		for (cy = 0; !failed && cy < hd.chunk_cols; cy++, i++)
+		{
+			failed = chunk_load(map, cx, cy);
+			if (failed)
+				break;
+			sums[i] = level_checksum(map->resident[0], sizeof(chunk),
+						 LEVEL_SEED);
+			failed = fwrite(map->resident[0], sizeof(chunk), 1, dst) != 1;
+			chunk_evict(map, 0);
+		}
+	if (!failed && (fwrite(ents->x, sizeof(double), n, dst) != n ||
+			fwrite(ents->y, sizeof(double), n, dst) != n ||
+			fwrite(ents->type, 1, n, dst) != n))
+		failed = 1;
+	sum = level_checksum(sums, sizeof(uint64_t) * i,
+			     level_checksum(&hd, sizeof(hd), LEVEL_SEED));
+	sum = level_checksum(ents->x, sizeof(double) * n, sum);
+	sum = level_checksum(ents->y, sizeof(double) * n, sum);
+	hd.checksum = level_checksum(ents->type, n, sum);
+	if (!failed && (fseek(dst, 0, SEEK_SET) != 0 ||
+			fwrite(&hd, sizeof(hd), 1, dst) != 1 ||
+			fwrite(sums, sizeof(uint64_t), i, dst) != i))
+		failed = 1;
+	if (dst != NULL && fclose(dst) != 0)
+		failed = 1;
+	if (failed)
+	{
+		perror(out);
+		if (dst != NULL)
+			remove(out);  /* Leave no half-written level behind */
+	}
+	else
+		printf("%s -> %s: %dx%d cells, %zu chunks, %zu entities\n", file,
+		       out, hd.width, hd.height, i, n);
+	free(sums);
+	grid_free(map);
+	return (failed);
+}
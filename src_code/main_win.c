@@ -1,4 +1,4 @@
-#include "../maze.h"
+#include "../maze_core.h"
 
 /**
  * print_win - Display a congratulatory message when the player wins the game
@@ -3,7 +3,7 @@
 /**
  * main - Entry point for the maze game
  * @argc: The number of command-line arguments passed to the program
- * @argv: The array of command-line arguments, including file paths for maze levels
+ * @argv: The array of command-line arguments: options, then file paths for maze levels
  * 
  * This is the main function responsible for initializing the game, handling player input,
  * rendering the maze, checking win conditions, and managing levels. It continues to loop
@@ -15,60 +15,188 @@
 int main(int argc, char *argv[])
 {
 	SDL_Instance instance;  // Holds the SDL instance for rendering
-	level *levels;           // Array of levels, each represented by a maze
-	int lvl, win_value, num_of_levels;
+	world *game;             // The level being played, and the next one
+	options opt;             // Command line options
+	worker_pool *pool;       // Threads casting the rays of every frame
+	columns cols;            // Rays cast for the current frame
+	ray_table rays;          // Rays of every column for the current view angle
+	sim_clock clk;           // Fixed timestep of the simulation
+	level view;              // The player's pose to draw, between two ticks
+	idle_stats idle;         // The frame on screen, and the time spent idle
+	ray_cost *cost = NULL;   // DDA steps of the rays, when counted
+	replay_log *log = NULL;  // Keys of every tick, recorded or replayed
+	char **files;            // The level files, in the order they are played
+	double start;            // Time the current frame started
+	uint64_t traced, scope;  // Time stamps of the frame and of its part, when tracing
+	int win_value, next, num_of_levels, first, unsaved;
 	keys key_press = {0, 0, 0, 0};  // Struct to track keyboard input for movement
 
-	lvl = win_value = 0;  // Initialize level and win flag
-	num_of_levels = argc;  // Number of levels equals number of command-line arguments
-	if (num_of_levels < 2)
+	win_value = next = 0;  // Initialize win flag and level loading status
+	rays.angle = -1;  // No view angle cached yet
+	first = parse_options(argc, argv, &opt);  // Index of the first level file
+	if (first < 0)
+	{
+		print_usage(argv[0]);
 		return (1);  // Exit if no levels are provided
+	}
+	num_of_levels = argc - first;  // Every remaining argument is a level
+	files = argv + first;
+
+	// A replay plays the levels it was recorded on, unless others are given
+	if (opt.replay != NULL)
+	{
+		log = replay_load(opt.replay);
+		if (log == NULL)
+			return (1);
+		if (num_of_levels == 0)
+		{
+			num_of_levels = log->levels;
+			files = log->files;
+		}
+	}
 
-	// Build the game world using the maze files passed via command-line arguments
-	levels = build_world_from_args(argc, argv);
-	if (levels == NULL)
+	// Load the first level, the next one loads in the background
+	game = world_create(num_of_levels, files);
+	if (game == NULL)
+	{
+		replay_free(log);
 		return (1);  // Exit if level creation fails
+	}
+
+	// Trace every frame, before the worker threads start, to dump on exit
+	if (opt.trace != NULL && trace_start(opt.trace, opt.budget) != 0)
+	{
+		replay_free(log);
+		world_free(game);
+		return (1);
+	}
+
+	// Replay the keys of a recorded game, a frame per tick, headless or in
+	// the window
+	if (log != NULL)
+	{
+		win_value = run_replay(game, &opt, log);
+		win_value |= trace_dump();
+		trace_stop();
+		world_free(game);
+		replay_free(log);
+		return (win_value);
+	}
+
+	// Run the simulation or benchmark the renderer headless instead of
+	// opening a window
+	if (opt.sim > 0 || opt.bench > 0)
+	{
+		win_value = opt.sim > 0 ? run_sim(game, &opt) : run_bench(game, &opt);
+		win_value |= trace_dump();
+		trace_stop();
+		world_free(game);
+		return (win_value);
+	}
 
 	// Initialize the SDL instance for rendering the maze and handling input
-	if (init_instance(&instance) != 0)
+	if (init_instance(&instance, opt.render, opt.fps == FPS_VSYNC) != 0)
+	{
+		trace_stop();
+		world_free(game);
 		return (1);  // Exit if SDL initialization fails
+	}
+	pool = pool_create(opt.threads);
+	if (opt.cost)
+		cost = instance.cost = cost_create();  // Shown with H
+	if (opt.record != NULL)  // Record the keys of every tick, to replay them
+		log = replay_create(opt.record, files, num_of_levels);
+	if (pool == NULL || (opt.cost && cost == NULL) ||
+	    (opt.record != NULL && log == NULL))
+	{
+		replay_free(log);
+		cost_free(cost);
+		pool_destroy(pool);
+		trace_stop();
+		world_free(game);
+		close_SDL(instance);
+		return (1);  // Exit if the worker threads or counters cannot be started
+	}
 
-	// Main game loop
+	// Main game loop: the simulation runs on a fixed tick, frames are
+	// drawn as often as the display, or the frame rate cap, allows
+	clock_reset(&clk, &game->stage);
+	idle_init(&idle);
 	while (1)
 	{
+		start = now_ns();
+		traced = trace_frame_begin();
+
 		// Check for player input and quit if necessary
-		if (keyboard_events(&key_press))
-		{
-			free_memory(instance, levels[lvl].map, levels[lvl].height);  // Free memory on quit
+		scope = trace_begin();
+		if (keyboard_events(&key_press, &idle.exposed))
 			break;  // Exit game loop if the player quits
-		}
+		trace_end(TRACE_INPUT, scope);
 
-		// Handle player movement and update their position based on keyboard input
-		movement(key_press, &levels[lvl].plane, &levels[lvl].dir, &levels[lvl].play,
-			 levels[lvl].map);
+		// Run the ticks due since the last frame: player movement, and
+		// moving to the next level when the player reaches the win spot
+		scope = trace_begin();
+		next = play_ticks(&clk, game, key_press, &win_value, log);
+		trace_end(TRACE_TICKS, scope);
+		if (next != 0)  // Check if all levels have been completed
+			break;  // Exit game loop when finished, or if the next level is bad
 
-		// Check if the player has reached the win spot in the current level
-		if (check_win(levels[lvl].play, levels[lvl].win, &win_value))
+		// Draw the player between the last two ticks
+		view = clock_view(&clk, &game->stage);
+
+		// Nothing moved: present the cached frame again if the window
+		// needs it, and sleep until an event instead of drawing the same
+		// frame; the time asleep is not simulated
+		if (frame_unchanged(&idle, &view, key_press))
 		{
-			free_map(levels[lvl].map, levels[lvl].height);  // Free the current map
-			lvl++;  // Move to the next level
-			if (lvl == argc - 1)  // Check if all levels have been completed
-				break;  // Exit game loop if the player has finished all levels
-			win_value = 0;  // Reset win flag for the next level
+			if (idle.exposed && present_cached(instance))
+				draw(instance, pool, view.map, &cols);  // Rays are still those of the frame
+			idle.exposed = 0;
+			trace_frame_end(traced);  // The sleep is not part of the frame
+			idle_wait(&idle);
+			clock_reset(&clk, &game->stage);
+			continue;
 		}
 
+		// Load the chunks of the map around the player, evict the far ones;
+		// a chunk that fails to load shows as walls and is retried next frame
+		grid_load_around(view.map, view.play);
+
+		// Cast the rays of every column across the worker threads
+		scope = trace_begin();
+		cast_frame(pool, opt.kernel, view.map, view.play, view.angle,
+			   &rays, &cols);
+		trace_end(TRACE_CAST, scope);
+		if (cost != NULL)  // Count the steps of the rays, per column and cell
+			cost_frame(cost, view.map, game->current, &rays, &cols);
+
 		// Render the maze and the player's position on the screen
-		draw(instance, levels[lvl].map, levels[lvl].play, levels[lvl].dir,
-		     levels[lvl].plane);
+		scope = trace_begin();
+		draw(instance, pool, view.map, &cols);
+		trace_end(TRACE_DRAW, scope);
+		frame_drawn(&idle, &view);
+		idle.exposed = 0;
+		trace_frame_end(traced);  // Not the wait for the frame rate cap
+		cap_frame(start, opt.fps);
 	}
 
-	// Clean up SDL resources and close the window
+	// Stop the worker threads, clean up SDL resources and close the window
+	pool_destroy(pool);
+	trace_dump();  // Write the trace of the last frames, if tracing
+	trace_stop();
+	draw_report(instance);  // Draw calls and state changes per frame
+	cost_report(cost);  // DDA steps per column and frame, if counted
+	cost_free(cost);
+	unsaved = log != NULL && replay_save(log, opt.record) != 0;
+	replay_free(log);
 	close_SDL(instance);
+	world_free(game);  // Release the levels still loaded
+	idle_report(&idle);  // Time spent idle, and its CPU and power use
 
 	// If the player completed all levels, print a win message
-	if (win_value)
+	if (win_value && next > 0)
 		print_win();
 
-	return (0);
+	return (next < 0 || unsaved);
 }
 
@@ -1,42 +1,131 @@
 #include "../maze.h"
 
 /**
- * build_world_from_args - Constructs the game world from the provided level files
- * @num_of_lvls: The total number of levels (command-line arguments passed)
+ * world_create - Constructs the game world from the provided level files
+ * @num_of_lvls: The total number of levels
  * @level_files: Array of strings representing file paths for each level
- * 
- * This function creates a series of levels for the game by reading the maze layout
- * from each file provided as a command-line argument. It dynamically allocates memory
- * for an array of level structures, and each level is populated with its map, player's
- * starting position, win condition, and other necessary data. The function will return
- * NULL if any error occurs during map creation or memory allocation.
- * 
- * Return: Pointer to an array of levels if successful, or NULL on failure
+ *
+ * This function loads the first level right away, then starts loading the
+ * second one on a background thread while the first is played. Only the
+ * level being played and the one after it are ever loaded, so startup time
+ * and memory do not grow with the number of level files. Each level starts
+ * from the same default stage, updated from its level file.
+ *
+ * Return: Pointer to the world if successful, or NULL if the first level
+ * cannot be loaded or memory allocation fails
  **/
-level *build_world_from_args(int num_of_lvls, char *level_files[])
+world *world_create(int num_of_lvls, char *level_files[])
 {
-	level stage = {NULL, 0, {0, 0}, {2, 2}, {-1, 0}, {0, 0.5} };  // Initialize a default stage
-	level *levels;
-	int i, lvl;
+	level stage = {NULL, {0, 0}, {2, 2}, START_ANGLE};  // Initialize a default stage, looking towards -x
+	world *game;
 
-	// Allocate memory for an array of levels, one for each level file
-	levels = malloc(sizeof(level) * (num_of_lvls - 1));
-	if (levels == NULL)
+	game = calloc(1, sizeof(world));
+	if (game == NULL)
 		return (NULL);  // Return NULL if memory allocation fails
+	game->files = level_files;
+	game->count = num_of_lvls;
 
-	lvl = 0;
-	// Iterate through each level file starting from the first argument (index 1)
-	for (i = 1; i < num_of_lvls; i++, lvl++)
+	// Load the first level now, it is played at once
+	stage.map = create_map(level_files[0], &stage.play, &stage.win,
+			       &stage.angle);
+	if (stage.map == NULL)
 	{
-		// Create the map for the current level and set up the stage properties
-		stage.map = create_map(level_files[i], &stage.play, &stage.win,
-				       &stage.height);
-		if (stage.map == NULL)
-			return (NULL);  // Return NULL if map creation fails
-
-		// Store the current stage in the levels array
-		levels[lvl] = stage;
+		free(game);
+		return (NULL);  // Return NULL if map creation fails
 	}
-	return (levels);  // Return the array of levels
+	game->stage = stage;
+
+	// Load the second level while the first one is played
+	world_prefetch(game);
+	return (game);
+}
+
+/**
+ * prefetch_level - Thread loading the level after the current one
+ * @arg: The world
+ *
+ * The thread only writes the next level of the world; the main thread
+ * does not look at it until it has joined the thread (world_sync).
+ *
+ * Return: NULL
+ **/
+void *prefetch_level(void *arg)
+{
+	level stage = {NULL, {0, 0}, {2, 2}, START_ANGLE};
+	world *game = arg;
+
+	stage.map = create_map(game->files[game->current + 1], &stage.play,
+			       &stage.win, &stage.angle);
+	game->next = stage;
+	return (NULL);
+}
+
+/**
+ * world_prefetch - Start loading the level after the current one
+ * @game: The world, with no prefetch running
+ *
+ * Nothing happens on the last level. If no thread can be started, the
+ * level is loaded right away instead.
+ **/
+void world_prefetch(world *game)
+{
+	game->next.map = NULL;
+	if (game->current + 1 >= game->count)
+		return;
+	game->loading = pthread_create(&game->loader, NULL, prefetch_level,
+				       game) == 0;
+	if (!game->loading)
+		prefetch_level(game);
+}
+
+/**
+ * world_sync - Wait for the prefetch of the next level to finish
+ * @game: The world
+ **/
+void world_sync(world *game)
+{
+	if (game->loading)
+		pthread_join(game->loader, NULL);
+	game->loading = 0;
 }
 
+/**
+ * world_advance - Move on to the next level
+ * @game: The world
+ *
+ * The current level is released first, so at most two levels are loaded
+ * at any time. The next level is normally loaded by then; otherwise this
+ * waits for it. The level after it starts loading in the background.
+ *
+ * Return: 0 on success, 1 if the current level was the last one, -1 if the
+ * next level could not be loaded (the error has been reported)
+ **/
+int world_advance(world *game)
+{
+	free_map(game->stage.map);
+	game->stage.map = NULL;
+	if (game->current + 1 >= game->count)
+		return (1);  // That was the last level
+	world_sync(game);
+	game->stage = game->next;
+	game->next.map = NULL;
+	game->current++;
+	if (game->stage.map == NULL)
+		return (-1);
+	world_prefetch(game);
+	return (0);
+}
+
+/**
+ * world_free - Release the world and every level still loaded
+ * @game: The world, may be NULL
+ **/
+void world_free(world *game)
+{
+	if (game == NULL)
+		return;
+	world_sync(game);
+	free_map(game->stage.map);
+	free_map(game->next.map);
+	free(game);
+}
@@ -0,0 +1,34 @@
+#include "../maze_core.h"
+
+/**
+ * main - Entry point of the level compiler
+ * @argc: The number of command-line arguments passed to the program
+ * @argv: The array of command-line arguments: the text levels to compile
+ *
+ * Each level is compiled next to its source, with LEVEL_SUFFIX appended to
+ * its name; the game loads either form. A level that fails does not stop
+ * the others from being compiled.
+ *
+ * Return: 0 if every level was compiled, 1 otherwise
+ **/
+int main(int argc, char *argv[])
+{
+	char *out;
+	int i, failed = 0;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s level_file...\n", argv[0]);
+		return (1);
+	}
+	for (i = 1; i < argc; i++)
+	{
+		out = malloc(strlen(argv[i]) + sizeof(LEVEL_SUFFIX));
+		if (out == NULL)
+			return (1);
+		sprintf(out, "%s%s", argv[i], LEVEL_SUFFIX);
+		failed |= compile_level(argv[i], out);
+		free(out);
+	}
+	return (failed);
+}
@@ -0,0 +1,65 @@
+#include "../maze_core.h"
+
+/**
+ * main - Entry point of the maze generator
+ * @argc: The number of command-line arguments passed to the program
+ * @argv: The array of command-line arguments: -s seed, -c to write a
+ * compiled level, -o file, then the width and height of the map
+ *
+ * The maze is streamed out a row at a time, to standard output or to the
+ * file, so its size is only limited by the level format. A compiled level
+ * needs a file it can seek in. The time taken and the cells generated per
+ * second are reported on standard error.
+ *
+ * Return: 0 if the maze was written, 1 otherwise
+ **/
+int main(int argc, char *argv[])
+{
+	maze_gen *g;
+	FILE *out = stdout;
+	char *file = NULL;
+	uint64_t seed = 1;
+	double start, secs;
+	int c, compiled = 0, width, height, failed;
+
+	while ((c = getopt(argc, argv, "s:co:")) != -1)
+		if (c == 's')
+			seed = strtoull(optarg, NULL, 0);
+		else if (c == 'c')
+			compiled = 1;
+		else if (c == 'o')
+			file = optarg;
+		else
+			optind = argc;  /* Bad option: print the usage */
+	width = optind + 2 == argc ? atoi(argv[optind]) : 0;
+	height = optind + 2 == argc ? atoi(argv[optind + 1]) : 0;
+	if (width < 3 || width >= MAP_MAX || height < 3 || height >= MAP_MAX ||
+	    (compiled && file == NULL))
+	{
+		fprintf(stderr, "Usage: %s [-s seed] [-c] [-o file] width height\n"
+			"Sizes from 3 to %d; -c needs -o\n", argv[0], MAP_MAX - 1);
+		return (1);
+	}
+	g = gen_create(width, height, seed);
+	if (file != NULL)
+		out = fopen(file, "wb");
+	if (g == NULL || out == NULL)
+	{
+		perror(file != NULL && out == NULL ? file : argv[0]);
+		gen_free(g);
+		return (1);
+	}
+	start = now_ns();
+	failed = compiled ? gen_write_level(g, out) : gen_write_text(g, out);
+	if ((out != stdout && fclose(out) != 0) || fflush(stdout) != 0)
+		failed = 1;
+	secs = (now_ns() - start) / 1e9;
+	if (failed)
+		perror(file != NULL ? file : argv[0]);
+	else
+		fprintf(stderr, "%dx%d cells, seed %llu, in %.3f s: %.1f Mcells/s\n",
+			g->width, g->height, (unsigned long long)seed, secs,
+			(double)g->width * g->height / secs / 1e6);
+	gen_free(g);
+	return (failed);
+}
@@ -0,0 +1,115 @@
+#include "../maze_core.h"
+
+/**
+ * random_actions - Draw random actions for every agent.
+ * @actions: Output for the AGENT_* bits of each agent.
+ * @count: The number of agents.
+ * @state: The state of the xorshift64 generator.
+ **/
+void random_actions(unsigned char *actions, int count, uint64_t *state)
+{
+	uint64_t bits = 0;
+	int i;
+
+	for (i = 0; i < count; i++, bits >>= 4)
+	{
+		if (i % 16 == 0)
+		{
+			*state ^= *state << 13;
+			*state ^= *state >> 7;
+			*state ^= *state << 17;
+			bits = *state;
+		}
+		actions[i] = bits & (AGENT_UP | AGENT_DOWN | AGENT_LEFT | AGENT_RIGHT);
+	}
+}
+
+/**
+ * main - Entry point of the agent simulation benchmark
+ * @argc: The number of command-line arguments passed to the program
+ * @argv: The array of command-line arguments: -t threads, -a agents,
+ * -n steps, -s seed, -o to render observations, then the levels the
+ * agents play
+ *
+ * Every agent holds random keys each step, and is put back at its start
+ * when it reaches its win square. With -o, what every agent sees is
+ * rendered after each step. Only the steps and the observations are
+ * timed, not drawing the actions.
+ *
+ * Return: 0 on success, 1 if a level cannot be loaded or memory runs out
+ **/
+int main(int argc, char *argv[])
+{
+	agent_sim *sim;
+	worker_pool *pool;
+	unsigned char *actions;
+	uint8_t *obs = NULL;
+	uint64_t state = 1;
+	double spent = 0, seen = 0, start;
+	long wins = 0;
+	int threads, agents = 4096, steps = 1000, c, n, i, won, observe = 0;
+
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+	while ((c = getopt(argc, argv, "t:a:n:s:o")) != -1)
+		if (c == 't' && (threads = atoi(optarg)) > 0)
+			continue;
+		else if (c == 'a' && (agents = atoi(optarg)) > 0)
+			continue;
+		else if (c == 'n' && (steps = atoi(optarg)) > 0)
+			continue;
+		else if (c == 's')
+			state = strtoull(optarg, NULL, 0) | 1;
+		else if (c == 'o')
+			observe = 1;
+		else
+			optind = argc;  /* Bad option: print the usage */
+	if (optind >= argc)
+	{
+		fprintf(stderr, "Usage: %s [-t threads] [-a agents] [-n steps] "
+			"[-s seed] [-o] level_file...\n", argv[0]);
+		return (1);
+	}
+	sim = sim_create(argv + optind, argc - optind, agents);
+	actions = malloc(agents);
+	pool = pool_create(threads);
+	if (observe)
+		obs = malloc((size_t)agents * OBS_HEIGHT * OBS_WIDTH * OBS_CHANNELS);
+	if (sim == NULL || actions == NULL || pool == NULL || (observe && !obs))
+	{
+		if (sim != NULL)
+			fprintf(stderr, "%s: out of memory\n", argv[0]);
+		sim_free(sim);
+		free(actions);
+		free(obs);
+		pool_destroy(pool);
+		return (1);
+	}
+	for (n = 0; n < steps; n++)
+	{
+		random_actions(actions, agents, &state);
+		start = now_ns();
+		won = sim_step(sim, pool, actions);
+		spent += now_ns() - start;
+		wins += won;
+		for (i = 0; won > 0 && i < agents; i++)
+			if (sim->done[i])
+				sim_reset(sim, i);
+		start = now_ns();
+		if (observe)
+			obs_render(sim, pool, obs);
+		seen += now_ns() - start;
+	}
+	printf("%d agents on %d level(s), %d steps in %.3f s on %d thread(s): "
+	       "%.1f M agent-steps/s, %ld wins\n", agents, argc - optind, steps,
+	       spent / 1e9, threads, (double)agents * steps / (spent / 1e3),
+	       wins);
+	if (observe)
+		printf("%dx%d observations in %.3f s: %.0f observations/s\n",
+		       OBS_WIDTH, OBS_HEIGHT, seen / 1e9,
+		       (double)agents * steps / (seen / 1e9));
+	pool_destroy(pool);
+	free(actions);
+	free(obs);
+	sim_free(sim);
+	return (0);
+}
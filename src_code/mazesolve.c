@@ -0,0 +1,59 @@
+#include "../maze_core.h"
+
+/**
+ * main - Entry point of the level checker
+ * @argc: The number of command-line arguments passed to the program
+ * @argv: The array of command-line arguments: -t threads, then the level
+ * files and directories of level files to check
+ *
+ * Every level is solved with each solver, a level per worker thread, and
+ * reported with the length of its shortest path, the cells each solver
+ * visited and the time each took. Reports are printed in the order the
+ * levels were given, once all are solved.
+ *
+ * Return: 0 if every level could be loaded and solved, 1 otherwise
+ **/
+int main(int argc, char *argv[])
+{
+	solve_result *results;
+	worker_pool *pool;
+	char **files;
+	double start, wall;
+	int threads, c, count, i, failed = 0;
+
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+	while ((c = getopt(argc, argv, "t:")) != -1)
+		if (c != 't' || (threads = atoi(optarg)) <= 0)
+			optind = argc;  /* Bad option: print the usage */
+	if (optind >= argc)
+	{
+		fprintf(stderr, "Usage: %s [-t threads] level_file|level_dir...\n",
+			argv[0]);
+		return (1);
+	}
+	threads = threads < 1 ? 1 : threads;
+	files = level_list(argv + optind, argc - optind, &count);
+	results = calloc(count > 0 ? count : 1, sizeof(solve_result));
+	pool = pool_create(threads);
+	if (files == NULL || results == NULL || pool == NULL)
+	{
+		fprintf(stderr, "%s: out of memory\n", argv[0]);
+		level_list_free(files, count);
+		free(results);
+		pool_destroy(pool);
+		return (1);
+	}
+	for (i = 0; i < count; i++)
+		results[i].file = files[i];
+	start = now_ns();
+	pool_run(pool, solve_range, results, count, 1);
+	wall = now_ns() - start;
+	for (i = 0; i < count; i++)
+		failed += solve_report(&results[i]);
+	printf("%d levels, %d solvable, checked in %.3f ms on %d thread(s)\n",
+	       count, count - failed, wall / 1e6, threads);
+	pool_destroy(pool);
+	free(results);
+	level_list_free(files, count);
+	return (failed > 0);
+}
@@ -0,0 +1,157 @@
+#include "../maze_core.h"
+
+/**
+ * obs_cells_load - Keep the map character of every cell of a level.
+ * @map: The grid of the level; its loaded chunks are evicted.
+ * @lv: The level, with its bitset loaded; @lv->cells is set.
+ *
+ * Return: 0 on success, 1 if memory runs out.
+ *
+ * Description: Laid out like the bitset (solve_grid_load), a byte for a
+ * bit, so a cell is at the same index in both. The rows above and below
+ * the map are sentinel walls.
+ **/
+int obs_cells_load(grid *map, sim_level *lv)
+{
+	const solve_grid *sg = &lv->open;
+	size_t row = sg->words * 64;
+	const chunk *c;
+	int cx, cy, i;
+
+	lv->cells = malloc(row * sg->rows);
+	if (lv->cells == NULL)
+		return (1);
+	memset(lv->cells, SENTINEL_WALL, row);
+	memset(lv->cells + row * (sg->rows - 1), SENTINEL_WALL, row);
+	while (map->count > 0)
+		chunk_evict(map, 0);
+	for (cx = 0; cx < (sg->rows - 2) / CHUNK_SIZE; cx++)
+		for (cy = 0; cy < (int)sg->words; cy++)
+		{
+			if (chunk_load(map, cx, cy) != 0)
+				return (1);
+			c = map->resident[0];
+			for (i = 0; i < CHUNK_SIZE; i++)
+				memcpy(lv->cells + (cx * CHUNK_SIZE + i + 1) * row +
+				       cy * CHUNK_SIZE, c->cells + i * CHUNK_SIZE,
+				       CHUNK_SIZE);
+			chunk_evict(map, 0);
+		}
+	return (0);
+}
+
+/**
+ * obs_render - Render what every agent sees.
+ * @sim: The simulation, with the pose of every agent.
+ * @pool: The worker pool to spread the agents over, or NULL.
+ * @out: The observations, OBS_HEIGHT x OBS_WIDTH x OBS_CHANNELS bytes per
+ * agent, row-major, in the order of the agents.
+ *
+ * Description: An observation is the frame the player would see from the
+ * pose of the agent, a sixteenth of the screen each way, with for every
+ * pixel the type of the wall seen (0 for the floor and ceiling), the side
+ * of the wall that was hit (0 for N/S, 1 for E/W) and the distance of what
+ * is seen, in OBS_DEPTH_SCALE steps per cell.
+ **/
+void obs_render(const agent_sim *sim, worker_pool *pool, uint8_t *out)
+{
+	obs_job job;
+	double depth;
+	int y;
+
+	job.sim = sim;
+	job.out = out;
+	for (y = 0; y < OBS_HEIGHT; y++)
+	{
+		job.rows[y] = (OBS_HEIGHT / 2) / fabs(y - OBS_HEIGHT / 2 + 0.5);
+		depth = job.rows[y] * OBS_DEPTH_SCALE;
+		job.floor[y][OBS_TYPE] = 0;
+		job.floor[y][OBS_SIDE] = 0;
+		job.floor[y][OBS_DEPTH] = depth < 255 ? (uint8_t)depth : 255;
+	}
+	pool_run(pool, obs_range, &job, sim->count, OBS_GRAIN);
+}
+
+/**
+ * obs_range - Render the observations of a range of agents.
+ * @arg: The obs_job describing the batch.
+ * @from: The first agent.
+ * @to: One past the last agent.
+ **/
+void obs_range(void *arg, int from, int to)
+{
+	const obs_job *job = arg;
+	int i;
+
+	for (i = from; i < to; i++)
+		obs_view(job, i);
+}
+
+/**
+ * obs_view - Render the observation of an agent.
+ * @job: The batch the agent is part of.
+ * @i: The agent.
+ *
+ * Description: A ray per column, stepped through the bits of the map as
+ * get_wall_dist steps through the grid, so it sees the walls the game
+ * draws. A pixel shows the wall when the wall is nearer than the floor or
+ * ceiling of its row, which is the slice wall_slice works out. The rays
+ * are all cast first, so the observation is then written in order.
+ **/
+void obs_view(const obs_job *job, int i)
+{
+	const agent_sim *sim = job->sim;
+	const sim_level *lv = &sim->levels[sim->level[i]];
+	uint8_t *obs = job->out + (size_t)i * OBS_HEIGHT * OBS_WIDTH *
+		OBS_CHANNELS, *px, type;
+	double_s play = {sim->x[i], sim->y[i]}, dir, first, side, delta;
+	int_s cell, step, count;
+	uint8_t wall[OBS_WIDTH][OBS_CHANNELS];
+	double cam, dist, depth;
+	int x, y, hit, far, band[OBS_WIDTH];
+
+	for (x = 0; x < OBS_WIDTH; x++)
+	{
+		cam = 2 * (x + 0.5) / OBS_WIDTH - 1;
+		dir.x = sim->dir_x[i] + sim->plane_x[i] * cam;
+		dir.y = sim->dir_y[i] + sim->plane_y[i] * cam;
+		delta.x = sqrt(1 + (dir.y * dir.y) / (dir.x * dir.x));
+		delta.y = sqrt(1 + (dir.x * dir.x) / (dir.y * dir.y));
+		cell.x = (int)play.x;
+		cell.y = (int)play.y;
+		check_ray_dir(&step, &first, play, cell, delta, dir);
+		side = first;
+		count.x = count.y = 0;
+		do {
+			hit = side.x >= side.y;
+			if (!hit)
+			{
+				side.x = first.x + ++count.x * delta.x;
+				cell.x += step.x;
+			}
+			else
+			{
+				side.y = first.y + ++count.y * delta.y;
+				cell.y += step.y;
+			}
+		} while (!solve_solid(&lv->open, cell.x, cell.y));
+		dist = wall_distance(cell, step, hit, play, dir);
+		far = cell.x < -1 || cell.x > lv->open.rows - 2 || cell.y < 0 ||
+			cell.y >= (int)lv->open.words * 64;
+		type = far ? SENTINEL_WALL : lv->cells[(size_t)(cell.x + 1) *
+						      lv->open.words * 64 + cell.y];
+		type = type >= '1' && type <= '9' ? type - '0' : OBS_SENTINEL;
+		/* The wall covers the rows of floor or ceiling further than it */
+		for (band[x] = 0; band[x] < OBS_HEIGHT / 2; band[x]++)
+			if (job->rows[OBS_HEIGHT / 2 + band[x]] < dist)
+				break;
+		depth = dist * OBS_DEPTH_SCALE;
+		wall[x][OBS_TYPE] = type;
+		wall[x][OBS_SIDE] = hit;
+		wall[x][OBS_DEPTH] = depth < 255 ? (uint8_t)depth : 255;
+	}
+	for (y = 0, px = obs; y < OBS_HEIGHT; y++)
+		for (x = 0; x < OBS_WIDTH; x++, px += OBS_CHANNELS)
+			memcpy(px, abs(2 * y + 1 - OBS_HEIGHT) < 2 * band[x] ?
+			       wall[x] : job->floor[y], OBS_CHANNELS);
+}
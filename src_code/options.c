@@ -0,0 +1,190 @@
+#include "../maze.h"
+
+/**
+ * print_usage - Print how to run the game.
+ * @name: The name the program was invoked with.
+ **/
+void print_usage(char *name)
+{
+	fprintf(stderr, "Usage: %s [-r lines|soft|batch] [-b frames [-V]] ", name);
+	fprintf(stderr, "[-t threads] [-k scalar|simd|fixed|skip] ");
+	fprintf(stderr, "[-f fps] [-s ticks] [-C] [-T trace [-B ms]] ");
+	fprintf(stderr, "[-R log] level_file...\n");
+	fprintf(stderr, "       %s -P log [-w] [options] [level_file...]\n",
+		name);
+	fprintf(stderr, "  -r  render path: SDL line drawing (default),\n");
+	fprintf(stderr, "      software framebuffer with one texture upload, or\n");
+	fprintf(stderr, "      rectangles batched by color\n");
+	fprintf(stderr, "  -b  render that many frames per level headless along\n");
+	fprintf(stderr, "      a scripted path and report frame times\n");
+	fprintf(stderr, "  -V  first check that the kernel casts exactly the\n");
+	fprintf(stderr, "      same rays as the scalar one (for fixed: report\n");
+	fprintf(stderr, "      how far it is from it)\n");
+	fprintf(stderr, "  -t  threads casting rays (default: one per core)\n");
+	fprintf(stderr, "  -k  ray kernel: vector packets of %d rays (default)\n",
+		PACKET_SIZE);
+	fprintf(stderr, "      or one ray at a time, in doubles or in 16.16\n");
+	fprintf(stderr, "      fixed point with reciprocal tables (positions in\n");
+	fprintf(stderr, "      48.16, so maps of any size), or in doubles\n");
+	fprintf(stderr, "      jumping across empty space (skip)\n");
+	fprintf(stderr, "  -f  cap the frame rate without vsync, 0 for no cap\n");
+	fprintf(stderr, "      (default: vsync); the game runs %d ticks a\n",
+		TICK_RATE);
+	fprintf(stderr, "      second whatever the frame rate\n");
+	fprintf(stderr, "  -s  run that many simulation ticks per level headless\n");
+	fprintf(stderr, "      along the scripted path, with no rendering\n");
+	fprintf(stderr, "  -C  count the DDA steps of the rays per column, frame\n");
+	fprintf(stderr, "      and cell, and report them; H shows them over the\n");
+	fprintf(stderr, "      frame\n");
+	fprintf(stderr, "  -T  trace where the time of every frame goes; written\n");
+	fprintf(stderr, "      to trace.json (Chrome trace events) and trace.csv\n");
+	fprintf(stderr, "      (a line per frame) on exit and on F12\n");
+	fprintf(stderr, "  -B  frame time budget of the trace in ms, frames over\n");
+	fprintf(stderr, "      it are reported as slow (default: %.1f); the\n",
+		TRACE_BUDGET_MS);
+	fprintf(stderr, "      time spent presenting, vsync waits included,\n");
+	fprintf(stderr, "      is not counted\n");
+	fprintf(stderr, "  -R  record the keys held at every tick to the log\n");
+	fprintf(stderr, "  -P  replay the log headless, a frame per tick with\n");
+	fprintf(stderr, "      the hash of every frame, on its levels or those\n");
+	fprintf(stderr, "      given\n");
+	fprintf(stderr, "  -w  replay in the window, with the render path of -r\n");
+}
+
+/**
+ * parse_options - Parse the command line options of the game.
+ * @argc: The number of command-line arguments.
+ * @argv: The command-line arguments.
+ * @opt: The options to fill in, set to their defaults first.
+ *
+ * Return: The index in argv of the first level file, argc if a replay was
+ * given none, or -1 if the options are invalid or no level file was given.
+ **/
+int parse_options(int argc, char **argv, options *opt)
+{
+	int c;
+
+	opt->render = RENDER_LINES;
+	opt->bench = 0;
+	opt->kernel = KERNEL_SIMD;
+	opt->verify = 0;
+	opt->fps = FPS_VSYNC;
+	opt->sim = 0;
+	opt->cost = 0;
+	opt->trace = NULL;
+	opt->budget = TRACE_BUDGET_MS;
+	opt->record = NULL;
+	opt->replay = NULL;
+	opt->window = 0;
+	opt->threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (opt->threads < 1)
+		opt->threads = 1;
+	while ((c = getopt(argc, argv, "r:b:t:k:Vf:s:CT:B:R:P:w")) != -1)
+	{
+		switch (c)
+		{
+		case 'r':
+			if (strcmp(optarg, "lines") == 0)
+				opt->render = RENDER_LINES;
+			else if (strcmp(optarg, "soft") == 0)
+				opt->render = RENDER_SOFT;
+			else if (strcmp(optarg, "batch") == 0)
+				opt->render = RENDER_BATCH;
+			else
+				return (-1);
+			break;
+		case 'b':
+			opt->bench = atoi(optarg);
+			if (opt->bench <= 0)
+				return (-1);
+			break;
+		case 'k':
+			if (strcmp(optarg, "scalar") == 0)
+				opt->kernel = KERNEL_SCALAR;
+			else if (strcmp(optarg, "simd") == 0)
+				opt->kernel = KERNEL_SIMD;
+			else if (strcmp(optarg, "fixed") == 0)
+				opt->kernel = KERNEL_FIXED;
+			else if (strcmp(optarg, "skip") == 0)
+				opt->kernel = KERNEL_SKIP;
+			else
+				return (-1);
+			break;
+		case 'V':
+			opt->verify = 1;
+			break;
+		case 't':
+			opt->threads = atoi(optarg);
+			if (opt->threads <= 0)
+				return (-1);
+			break;
+		case 'f':
+			opt->fps = atoi(optarg);
+			if (opt->fps < 0)
+				return (-1);
+			break;
+		case 's':
+			opt->sim = atoi(optarg);
+			if (opt->sim <= 0)
+				return (-1);
+			break;
+		case 'R':
+			opt->record = optarg;
+			break;
+		case 'P':
+			opt->replay = optarg;
+			break;
+		case 'w':
+			opt->window = 1;
+			break;
+		case 'C':
+			opt->cost = 1;
+			break;
+		case 'T':
+			opt->trace = optarg;
+			break;
+		case 'B':
+			opt->budget = atof(optarg);
+			if (opt->budget <= 0)
+				return (-1);
+			break;
+		default:
+			return (-1);
+		}
+	}
+	if (optind >= argc && opt->replay == NULL)
+		return (-1);  /* Only a replay knows its levels */
+	return (optind);
+}
+
+/**
+ * kernel_name - Get the name of a ray kernel, as given to -k.
+ * @kernel: The kernel.
+ *
+ * Return: The name of the kernel.
+ **/
+const char *kernel_name(int kernel)
+{
+	if (kernel == KERNEL_FIXED)
+		return ("fixed");
+	if (kernel == KERNEL_SKIP)
+		return ("skip");
+	if (kernel == KERNEL_SIMD)
+		return ("simd");
+	return ("scalar");
+}
+
+/**
+ * render_name - Get the name of a render path, as given to -r.
+ * @mode: The render path.
+ *
+ * Return: The name of the render path.
+ **/
+const char *render_name(int mode)
+{
+	if (mode == RENDER_SOFT)
+		return ("soft");
+	if (mode == RENDER_BATCH)
+		return ("batch");
+	return ("lines");
+}
@@ -0,0 +1,245 @@
+#include "../maze.h"
+
+/**
+ * cost_create - Create the ray cost counters.
+ *
+ * Return: The counters, all zero, or NULL if memory runs out; the error
+ * has been reported.
+ **/
+ray_cost *cost_create(void)
+{
+	ray_cost *rc = calloc(1, sizeof(ray_cost));
+
+	if (rc == NULL)
+	{
+		fprintf(stderr, "ray cost: out of memory\n");
+		return (NULL);
+	}
+	rc->level = -1;
+	return (rc);
+}
+
+/**
+ * cost_level - Start counting the cells of a new level.
+ * @rc: The counters.
+ * @map: The grid of the level.
+ * @level: The index of the level.
+ *
+ * Return: 0 on success, 1 if memory runs out; the cells of the level are
+ * then not counted, the columns and frames still are.
+ *
+ * Description: The counters of the cells of the last level are freed.
+ * Those of a chunk are only allocated once a ray crosses it, so the
+ * counters take the memory of the chunks the player got near, whatever
+ * the size of the map.
+ **/
+int cost_level(ray_cost *rc, const grid *map, int level)
+{
+	size_t i;
+
+	for (i = 0; rc->heat != NULL && i < rc->blocks; i++)
+		free(rc->heat[i]);
+	free(rc->heat);
+	rc->level = level;
+	rc->map = map;
+	rc->heat_max = 0;
+	rc->hottest.x = rc->hottest.y = 0;
+	rc->blocks = (size_t)map->dir_stride *
+		((map->height + CHUNK_SIZE - 1) / CHUNK_SIZE + 2);
+	rc->heat = calloc(rc->blocks, sizeof(uint32_t *));
+	if (rc->heat == NULL)
+	{
+		fprintf(stderr, "ray cost: out of memory, cells not counted\n");
+		rc->blocks = 0;
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * cost_frame - Count the DDA steps of the rays of a frame.
+ * @rc: The counters.
+ * @map: The grid of the level the rays were cast in.
+ * @level: The index of the level; a new one starts counting its cells.
+ * @rays: The ray table the frame was cast with.
+ * @cols: The rays of every column of the frame, already cast.
+ *
+ * Description: get_wall_dist steps a ray one cell along x or y at a time,
+ * from the cell of the player to the wall it hits, so the steps of a
+ * column are the x and y cells between the two, whatever the kernel that
+ * cast it. The rays are then walked again to count the cells they cross,
+ * on the calling thread.
+ **/
+void cost_frame(ray_cost *rc, const grid *map, int level,
+		const ray_table *rays, const columns *cols)
+{
+	int_s start = {(int)cols->play.x, (int)cols->play.y};
+	uint32_t steps;
+	int screen_x;
+
+	if (rc->level != level)
+		cost_level(rc, map, level);
+	rc->play = cols->play;
+	rc->frame = 0;
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		steps = abs(cols->cell[screen_x].x - start.x) +
+			abs(cols->cell[screen_x].y - start.y);
+		rc->column[screen_x] = steps;
+		rc->frame += steps;
+		rc->column_hist[cost_bin(steps)]++;
+		if (steps > rc->column_max)
+			rc->column_max = steps;
+	}
+	rc->total += rc->frame;
+	rc->frames++;
+	rc->frame_hist[cost_bin(rc->frame)]++;
+	if (rc->frame > rc->frame_max)
+		rc->frame_max = rc->frame;
+	for (screen_x = 0; rc->heat != NULL && screen_x < SCREEN_WIDTH;
+	     screen_x++)
+		cost_walk(rc, rays, screen_x);
+}
+
+/**
+ * cost_walk - Count the cells the ray of a column crosses.
+ * @rc: The counters, with the steps of the column.
+ * @rays: The ray table the frame was cast with.
+ * @screen_x: The column.
+ *
+ * Description: The ray is stepped as get_wall_dist steps it, and every
+ * step is counted on the cell it leaves: the cell of the player and the
+ * empty cells up to the wall, so the counts of the cells add up to the
+ * steps of the frames.
+ **/
+void cost_walk(ray_cost *rc, const ray_table *rays, int screen_x)
+{
+	ray_state ray;
+	double_s side;
+	int_s count = {0, 0};
+	uint32_t **block, *heat;
+	size_t entry;
+	uint32_t i;
+
+	ray_setup(rc->play, rays, screen_x, &ray);
+	side = ray.side;
+	for (i = 0; i < rc->column[screen_x]; i++)
+	{
+		entry = (size_t)((ray.cell.x >> CHUNK_SHIFT) + 1) *
+			rc->map->dir_stride + (ray.cell.y >> CHUNK_SHIFT) + 1;
+		block = entry < rc->blocks ? &rc->heat[entry] : NULL;
+		if (block != NULL && *block == NULL)
+			*block = calloc(CHUNK_SIZE * CHUNK_SIZE, sizeof(uint32_t));
+		if (block != NULL && *block != NULL)
+		{
+			heat = &(*block)[(ray.cell.x & (CHUNK_SIZE - 1)) * CHUNK_SIZE +
+					 (ray.cell.y & (CHUNK_SIZE - 1))];
+			if (++*heat > rc->heat_max)
+			{
+				rc->heat_max = *heat;
+				rc->hottest = ray.cell;
+			}
+		}
+		if (side.x < side.y)
+		{
+			side.x = ray.side.x + ++count.x * ray.delta.x;
+			ray.cell.x += ray.step.x;
+		}
+		else
+		{
+			side.y = ray.side.y + ++count.y * ray.delta.y;
+			ray.cell.y += ray.step.y;
+		}
+	}
+}
+
+/**
+ * cost_heat - Get the steps taken out of a cell of the level.
+ * @rc: The counters.
+ * @x: The row of the cell.
+ * @y: The column of the cell.
+ *
+ * Return: The steps, 0 for a cell no ray crossed or outside the map.
+ **/
+uint32_t cost_heat(const ray_cost *rc, int x, int y)
+{
+	const uint32_t *block;
+	int cx = (x >> CHUNK_SHIFT) + 1, cy = (y >> CHUNK_SHIFT) + 1;
+	size_t entry = (size_t)cx * rc->map->dir_stride + cy;
+
+	if (rc->heat == NULL || cx < 0 || cy < 0 ||
+	    cy >= rc->map->dir_stride || entry >= rc->blocks)
+		return (0);
+	block = rc->heat[entry];
+	if (block == NULL)
+		return (0);
+	return (block[(x & (CHUNK_SIZE - 1)) * CHUNK_SIZE +
+		      (y & (CHUNK_SIZE - 1))]);
+}
+
+/**
+ * cost_bin - Get the histogram bin of a number of steps.
+ * @steps: The steps.
+ *
+ * Return: 0 for no step, else the number of bits of @steps: bin b holds
+ * 2^(b-1) to 2^b - 1 steps. The last bin holds everything above.
+ **/
+int cost_bin(uint64_t steps)
+{
+	int bin = steps == 0 ? 0 : 64 - __builtin_clzll(steps);
+
+	return (bin < COST_BINS ? bin : COST_BINS - 1);
+}
+
+/**
+ * cost_report - Print the ray cost of the frames counted.
+ * @rc: The counters, may be NULL.
+ *
+ * Description: The mean and most steps per column and per frame, the
+ * hottest cell of the last level, then the histograms of the steps of the
+ * columns and of the frames, side by side, over the bins holding any.
+ **/
+void cost_report(const ray_cost *rc)
+{
+	int bin, first = COST_BINS, last = 0;
+
+	if (rc == NULL || rc->frames == 0)
+		return;
+	printf("rays: %ld frames, %.1f DDA steps per column (up to %u), %.0f "
+	       "per frame (up to %llu)\n", rc->frames,
+	       (double)rc->total / rc->frames / SCREEN_WIDTH, rc->column_max,
+	       (double)rc->total / rc->frames,
+	       (unsigned long long)rc->frame_max);
+	if (rc->heat_max > 0)
+		printf("rays: hottest cell of the last level (%d, %d), %u steps\n",
+		       rc->hottest.x, rc->hottest.y, rc->heat_max);
+	for (bin = 0; bin < COST_BINS; bin++)
+		if (rc->column_hist[bin] > 0 || rc->frame_hist[bin] > 0)
+		{
+			first = bin < first ? bin : first;
+			last = bin;
+		}
+	printf("rays: %-17s %8s %8s\n", "steps", "columns", "frames");
+	for (bin = first; bin <= last; bin++)
+		printf("rays: %8llu-%-8llu %7.2f%% %7.2f%%\n",
+		       bin == 0 ? 0ULL : 1ULL << (bin - 1),
+		       bin == 0 ? 0ULL : (1ULL << bin) - 1,
+		       100.0 * rc->column_hist[bin] / rc->frames / SCREEN_WIDTH,
+		       100.0 * rc->frame_hist[bin] / rc->frames);
+}
+
+/**
+ * cost_free - Free the ray cost counters.
+ * @rc: The counters, may be NULL.
+ **/
+void cost_free(ray_cost *rc)
+{
+	size_t i;
+
+	if (rc == NULL)
+		return;
+	for (i = 0; rc->heat != NULL && i < rc->blocks; i++)
+		free(rc->heat[i]);
+	free(rc->heat);
+	free(rc);
+}
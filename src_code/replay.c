@@ -0,0 +1,271 @@
+#include "../maze.h"
+
+/**
+ * replay_create - Start recording the keys of a game to a replay log.
+ * @path: The path of the log file, created or truncated.
+ * @files: The level files of the game, in the order they are played.
+ * @levels: The number of level files.
+ *
+ * Return: The log, or NULL if the file cannot be written or memory runs
+ * out; the error has been reported.
+ *
+ * Description: The header is written last, by replay_save, once the ticks
+ * are known; until then it is zero, and the log cannot be replayed.
+ **/
+replay_log *replay_create(const char *path, char **files, int levels)
+{
+	replay_log *log = calloc(1, sizeof(replay_log));
+	replay_header hd;
+	int32_t length;
+	int i, failed;
+
+	if (log == NULL)
+	{
+		fprintf(stderr, "%s: out of memory\n", path);
+		return (NULL);
+	}
+	memset(&hd, 0, sizeof(hd));
+	log->levels = levels;
+	log->out = fopen(path, "wb");
+	failed = log->out == NULL || fwrite(&hd, sizeof(hd), 1, log->out) != 1;
+	for (i = 0; !failed && i < levels; i++)
+	{
+		length = strlen(files[i]);
+		failed = fwrite(&length, sizeof(length), 1, log->out) != 1 ||
+			fwrite(files[i], 1, length, log->out) != (size_t)length;
+	}
+	if (failed)
+	{
+		perror(path);
+		if (log->out != NULL)
+			fclose(log->out);
+		free(log);
+		return (NULL);
+	}
+	return (log);
+}
+
+/**
+ * replay_record - Record the keys held during a tick.
+ * @log: The log being recorded.
+ * @key_press: The keys movement is given for the tick.
+ *
+ * Description: Ticks holding the same keys are counted into one run, of
+ * up to REPLAY_RUN ticks; a run is written once it ends, so a tick costs
+ * a comparison, and a second of holding the same keys four bytes. A run
+ * that cannot be written fails the log, when it is saved.
+ **/
+void replay_record(replay_log *log, keys key_press)
+{
+	int held = (key_press.up ? AGENT_UP : 0) |
+		(key_press.down ? AGENT_DOWN : 0) |
+		(key_press.left ? AGENT_LEFT : 0) |
+		(key_press.right ? AGENT_RIGHT : 0);
+
+	if (log->length > 0 && (held != log->held || log->length == REPLAY_RUN))
+		log->failed |= replay_flush(log);
+	log->held = held;
+	log->length++;
+	log->ticks++;
+}
+
+/**
+ * replay_flush - Write the run being recorded.
+ * @log: The log being recorded.
+ *
+ * Return: 0 on success, 1 if it cannot be written.
+ **/
+int replay_flush(replay_log *log)
+{
+	if (log->length == 0)
+		return (0);
+	if (fputc(log->held | (log->length - 1) << 4, log->out) == EOF)
+		return (1);
+	log->count++;
+	log->length = 0;
+	return (0);
+}
+
+/**
+ * replay_save - Finish recording a replay log.
+ * @log: The log being recorded; its file is closed.
+ * @path: The path of the log file, to report errors.
+ *
+ * Return: 0 on success, 1 if the log, or any run of it, cannot be
+ * written; the error has been reported.
+ **/
+int replay_save(replay_log *log, const char *path)
+{
+	replay_header hd;
+	int failed;
+
+	memset(&hd, 0, sizeof(hd));
+	memcpy(hd.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+	hd.version = REPLAY_VERSION;
+	hd.levels = log->levels;
+	hd.ticks = log->ticks;
+	failed = log->failed | replay_flush(log);
+	hd.runs = log->count;
+	/* A log missing runs keeps its zero header, so it is never replayed */
+	if (!failed)
+		failed = fseek(log->out, 0, SEEK_SET) != 0 ||
+			fwrite(&hd, sizeof(hd), 1, log->out) != 1;
+	failed |= fclose(log->out) != 0;
+	log->out = NULL;
+	if (failed)
+		perror(path);
+	else
+		printf("replay: %lld ticks recorded to %s\n", (long long)log->ticks,
+		       path);
+	return (failed);
+}
+
+/**
+ * replay_load - Load a replay log to replay it.
+ * @path: The path of the log file.
+ *
+ * Return: The log, at its first tick, or NULL if it cannot be read, is not
+ * a replay log, or memory runs out; the error has been reported.
+ **/
+replay_log *replay_load(const char *path)
+{
+	replay_log *log = calloc(1, sizeof(replay_log));
+	FILE *in = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size = -1;
+	int failed;
+
+	if (in != NULL && fseek(in, 0, SEEK_END) == 0)
+		size = ftell(in);
+	if (size >= 0 && fseek(in, 0, SEEK_SET) == 0)
+		data = malloc(size > 0 ? size : 1);
+	if (log == NULL || data == NULL ||
+	    fread(data, 1, size, in) != (size_t)size)
+	{
+		perror(path);
+		failed = 1;
+	}
+	else
+		failed = replay_read(log, data, size, path);
+	if (in != NULL)
+		fclose(in);
+	free(data);
+	if (failed)
+	{
+		replay_free(log);
+		return (NULL);
+	}
+	return (log);
+}
+
+/**
+ * replay_read - Parse a replay log.
+ * @log: Output for the level files and the runs of the log.
+ * @data: The log file.
+ * @size: Its size in bytes.
+ * @path: Its path, to report errors.
+ *
+ * Return: 0 on success, 1 if it is not a sound replay log or memory runs
+ * out; the error has been reported.
+ **/
+int replay_read(replay_log *log, const uint8_t *data, size_t size,
+		const char *path)
+{
+	replay_header hd;
+	size_t at = sizeof(hd);
+	int64_t ticks = 0, i;
+	int32_t length;
+
+	memcpy(&hd, data, size < sizeof(hd) ? size : sizeof(hd));
+	if (size < sizeof(hd) || memcmp(hd.magic, REPLAY_MAGIC,
+					 sizeof(REPLAY_MAGIC)) != 0)
+	{
+		fprintf(stderr, "%s: not a replay log, or not saved\n", path);
+		return (1);
+	}
+	if (hd.version != REPLAY_VERSION || hd.levels < 1 || hd.runs < 0)
+	{
+		fprintf(stderr, "%s: replay log of another version, or corrupt\n",
+			path);
+		return (1);
+	}
+	log->files = calloc(hd.levels, sizeof(char *));
+	if (log->files == NULL)
+		return (1);
+	for (; log->levels < hd.levels; log->levels++)
+	{
+		if (size - at < sizeof(length))
+			break;
+		memcpy(&length, data + at, sizeof(length));
+		at += sizeof(length);
+		if (length < 0 || size - at < (size_t)length)
+			break;
+		log->files[log->levels] = strndup((const char *)data + at, length);
+		if (log->files[log->levels] == NULL)
+			return (1);
+		at += length;
+	}
+	if (log->levels < hd.levels || (size_t)hd.runs != size - at)
+	{
+		fprintf(stderr, "%s: truncated or corrupt replay log\n", path);
+		return (1);
+	}
+	log->runs = malloc(hd.runs > 0 ? hd.runs : 1);
+	if (log->runs == NULL)
+		return (1);
+	memcpy(log->runs, data + at, hd.runs);
+	for (i = 0; i < hd.runs; i++)
+		ticks += (log->runs[i] >> 4) + 1;
+	log->count = hd.runs;
+	log->ticks = hd.ticks;
+	if (ticks != hd.ticks)
+	{
+		fprintf(stderr, "%s: corrupt replay log\n", path);
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * replay_next - Get the keys of the next tick of a replay log.
+ * @log: The log being replayed.
+ * @key_press: Output for the keys held during the tick.
+ *
+ * Return: 1 if there was a tick left, 0 at the end of the log.
+ **/
+int replay_next(replay_log *log, keys *key_press)
+{
+	if (log->left == 0)
+	{
+		if (log->at >= log->count)
+			return (0);
+		log->held = log->runs[log->at] & 0xF;
+		log->left = (log->runs[log->at] >> 4) + 1;
+		log->at++;
+	}
+	log->left--;
+	key_press->up = (log->held & AGENT_UP) != 0;
+	key_press->down = (log->held & AGENT_DOWN) != 0;
+	key_press->left = (log->held & AGENT_LEFT) != 0;
+	key_press->right = (log->held & AGENT_RIGHT) != 0;
+	return (1);
+}
+
+/**
+ * replay_free - Free a replay log.
+ * @log: The log, may be NULL; one still recorded is closed, unsaved.
+ **/
+void replay_free(replay_log *log)
+{
+	int i;
+
+	if (log == NULL)
+		return;
+	if (log->out != NULL)
+		fclose(log->out);
+	for (i = 0; log->files != NULL && i < log->levels; i++)
+		free(log->files[i]);
+	free(log->files);
+	free(log->runs);
+	free(log);
+}
@@ -0,0 +1,158 @@
+#include "../maze.h"
+
+/**
+ * run_replay - Replay the keys of a recorded game, as fast as it can.
+ * @game: The levels the game was recorded on, from the first one.
+ * @opt: The options: the window, render path, threads and ray kernel.
+ * @log: The replay log, at its first tick.
+ *
+ * Return: 0 if the whole log was replayed, 1 if the buffers or the window
+ * cannot be set up, a level cannot be loaded, or the game ended before
+ * the log did, which means the replay does not match the recording.
+ *
+ * Description: Every tick of the log is one frame: the tick runs as in
+ * the game, win checks and level changes included, then the frame is cast
+ * and drawn at the player's pose after it, with no clock, no vsync and no
+ * interpolation, so the same log always draws the same frames. Headless,
+ * frames are drawn by the software path into an offscreen framebuffer;
+ * with -w they are drawn and presented by the render path chosen, and ESC
+ * stops the replay. A line per frame gives its pose and hash
+ * (replay_hash), and the last one a hash of every frame; those are the
+ * lines starting with "frame", and they only change if the output does.
+ * The frame times are reported as by the benchmark.
+ **/
+int run_replay(world *game, options *opt, replay_log *log)
+{
+	SDL_Instance instance;
+	worker_pool *pool;
+	double *times;
+	long frames = 0;
+	int failed;
+
+	memset(&instance, 0, sizeof(instance));
+	if (opt->window && init_instance(&instance, opt->render, 0) != 0)
+		return (1);
+	if (!opt->window)
+	{
+		instance.pixels = malloc(sizeof(Uint32) * SCREEN_WIDTH *
+					 SCREEN_HEIGHT);
+		instance.tex = atlas_load(TEX_DIR);
+	}
+	times = malloc(sizeof(double) * (log->ticks > 0 ? log->ticks : 1));
+	pool = pool_create(opt->threads);
+	failed = times == NULL || pool == NULL ||
+		(!opt->window && (instance.pixels == NULL || instance.tex == NULL));
+	if (!failed)
+	{
+		failed = replay_frames(game, opt, log, &instance, pool, times,
+				       &frames);
+		if (frames > 0)
+			printf("replay: ");
+		report_bench(times, frames);
+	}
+	pool_destroy(pool);
+	free(times);
+	if (opt->window)
+		close_SDL(instance);
+	else
+	{
+		free(instance.pixels);
+		free(instance.tex);
+	}
+	return (failed);
+}
+
+/**
+ * replay_frames - Replay the ticks of a log, a frame per tick.
+ * @game: The levels, from the first one.
+ * @opt: The options: the window and the ray kernel.
+ * @log: The replay log, at its first tick.
+ * @instance: The window, or for a headless replay only the framebuffer
+ * and the textures.
+ * @pool: The worker pool casting the rays.
+ * @times: Output for the time of every frame, in nanoseconds.
+ * @frames: Output for the number of frames drawn.
+ *
+ * Return: 0 on success, 1 if a level cannot be loaded or the game ended
+ * before the log did; the error has been reported.
+ **/
+int replay_frames(world *game, options *opt, replay_log *log,
+		  SDL_Instance *instance, worker_pool *pool, double *times,
+		  long *frames)
+{
+	level *stage = &game->stage;
+	ray_table rays;
+	columns cols;
+	sim_clock clk;
+	keys key_press, ignored = {0, 0, 0, 0};
+	uint64_t hash, sum = LEVEL_SEED, traced, scope;
+	double start;
+	int won = 0, next = 0, exposed = 0;
+
+	rays.angle = -1;
+	clock_reset(&clk, stage);
+	while (replay_next(log, &key_press))
+	{
+		start = now_ns();
+		traced = trace_frame_begin();
+		if (opt->window && keyboard_events(&ignored, &exposed))
+			break;  /* Stopped with ESC: the rest is not replayed */
+		clock_tick(&clk, stage, key_press);
+		if (check_win(stage->play, stage->win, &won))
+		{
+			next = world_advance(game);
+			if (next != 0)
+				break;
+			won = 0;
+			clock_reset(&clk, stage);
+		}
+		grid_load_around(stage->map, stage->play);
+		scope = trace_begin();
+		cast_frame(pool, opt->kernel, stage->map, stage->play, stage->angle,
+			   &rays, &cols);
+		trace_end(TRACE_CAST, scope);
+		scope = trace_begin();
+		if (opt->window)
+			draw(*instance, pool, stage->map, &cols);
+		else
+			draw_frame_soft(instance->pixels, instance->tex, pool,
+					stage->map, &cols);
+		trace_end(TRACE_DRAW, scope);
+		trace_frame_end(traced);
+		times[(*frames)++] = now_ns() - start;
+		hash = replay_hash(stage, game->current, instance->pixels);
+		sum = level_checksum(&hash, sizeof(hash), sum);
+		printf("frame %ld: level %d, (%.17g, %.17g), angle %d, hash %016llx\n",
+		       *frames, game->current + 1, stage->play.x, stage->play.y,
+		       stage->angle, (unsigned long long)hash);
+	}
+	printf("frames: %ld of %lld ticks, hash %016llx\n", *frames,
+	       (long long)log->ticks, (unsigned long long)sum);
+	if (next < 0 || (next > 0 && replay_next(log, &key_press)))
+	{
+		fprintf(stderr, "replay: %s\n", next < 0 ? "a level cannot be loaded"
+			: "the game ended before the log, the replay diverged");
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * replay_hash - Hash the pose and the frame drawn after a tick.
+ * @stage: The level, with the player's pose.
+ * @current: The index of the level.
+ * @pixels: The framebuffer drawn, or NULL if there is none (line and
+ * batched paths); only the pose is hashed then.
+ *
+ * Return: The hash, with level_checksum.
+ **/
+uint64_t replay_hash(const level *stage, int current, const Uint32 *pixels)
+{
+	double pose[4] = {current, stage->play.x, stage->play.y, stage->angle};
+	uint64_t sum = level_checksum(pose, sizeof(pose), LEVEL_SEED);
+
+	if (pixels != NULL)
+		sum = level_checksum(pixels, sizeof(Uint32) * SCREEN_WIDTH *
+				     SCREEN_HEIGHT, sum);
+	return (sum);
+}
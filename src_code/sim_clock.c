@@ -0,0 +1,184 @@
+#include "../maze.h"
+
+/**
+ * clock_reset - Start the simulation clock of a level.
+ * @clk: The clock.
+ * @stage: The level, at its start pose.
+ *
+ * Description: Nothing is owed to the simulation yet, and the pose before
+ * the last tick is the start pose, so the first frames show it as is.
+ **/
+void clock_reset(sim_clock *clk, level *stage)
+{
+	clk->last = now_ns();
+	clk->lag = 0;
+	clk->prev_play = stage->play;
+	clk->prev_angle = stage->angle;
+}
+
+/**
+ * clock_ticks - Count the simulation ticks due since the last call.
+ * @clk: The clock.
+ *
+ * Return: The number of ticks to run now, at most MAX_LAG_TICKS.
+ *
+ * Description: The time elapsed is added to the lag, and every whole
+ * TICK_NS of it is one tick. What is left is less than a tick, and sets how
+ * far between the last two ticks the player is drawn (clock_view). After a
+ * stall, such as a window drag or a level load, the time beyond
+ * MAX_LAG_TICKS is dropped, so the game pauses instead of running a burst
+ * of ticks that takes longer still.
+ **/
+int clock_ticks(sim_clock *clk)
+{
+	double now = now_ns();
+	int ticks;
+
+	clk->lag += now - clk->last;
+	clk->last = now;
+	if (clk->lag > MAX_LAG_TICKS * TICK_NS)
+		clk->lag = MAX_LAG_TICKS * TICK_NS;
+	ticks = clk->lag / TICK_NS;
+	clk->lag -= ticks * TICK_NS;
+	return (ticks);
+}
+
+/**
+ * clock_tick - Run one tick of the simulation.
+ * @clk: The clock.
+ * @stage: The level being played.
+ * @key_press: The keys held during the tick.
+ *
+ * Description: The player's pose before the tick is kept to draw the
+ * frames until the next tick. Moving and turning speeds are per tick, so
+ * the game plays at the same speed whatever the frame rate.
+ **/
+void clock_tick(sim_clock *clk, level *stage, keys key_press)
+{
+	clk->prev_play = stage->play;
+	clk->prev_angle = stage->angle;
+	movement(key_press, &stage->angle, &stage->play, stage->map);
+}
+
+/**
+ * play_ticks - Run the simulation ticks due since the last frame.
+ * @clk: The clock.
+ * @game: The levels; the player is in the current one.
+ * @key_press: The keys held since the last frame.
+ * @win_value: Set to 1 when the player reaches the win square.
+ * @rec: The replay log to record the keys of every tick to, or NULL.
+ *
+ * Return: 0 to keep playing, 1 if the last level was won, -1 if the next
+ * level could not be loaded.
+ *
+ * Description: When the player wins a level, the ticks left over are
+ * dropped and the clock restarts on the next level, so the time spent
+ * waiting for the level to load is not made up for.
+ **/
+int play_ticks(sim_clock *clk, world *game, keys key_press, int *win_value,
+	       replay_log *rec)
+{
+	int ticks = clock_ticks(clk), next;
+
+	while (ticks-- > 0)
+	{
+		if (rec != NULL)
+			replay_record(rec, key_press);
+		clock_tick(clk, &game->stage, key_press);
+		if (check_win(game->stage.play, game->stage.win, win_value))
+		{
+			next = world_advance(game);
+			if (next != 0)
+				return (next);
+			*win_value = 0;  /* Reset win flag for the next level */
+			clock_reset(clk, &game->stage);
+			return (0);
+		}
+	}
+	return (0);
+}
+
+/**
+ * clock_view - Get the player's pose to draw.
+ * @clk: The clock.
+ * @stage: The level being played, at its pose after the last tick.
+ *
+ * Return: The level with the player's pose blended between the last two
+ * ticks by the lag left over, so movement looks smooth at any frame rate.
+ * The angle turns the short way round and is rounded to a table angle.
+ **/
+level clock_view(sim_clock *clk, level *stage)
+{
+	double t = clk->lag / TICK_NS;
+	level view = *stage;
+	int turn;
+
+	turn = ((stage->angle - clk->prev_angle + ANGLE_STEPS / 2) &
+		(ANGLE_STEPS - 1)) - ANGLE_STEPS / 2;
+	view.play.x = clk->prev_play.x + (stage->play.x - clk->prev_play.x) * t;
+	view.play.y = clk->prev_play.y + (stage->play.y - clk->prev_play.y) * t;
+	view.angle = (clk->prev_angle + (int)lround(turn * t)) & (ANGLE_STEPS - 1);
+	return (view);
+}
+
+/**
+ * cap_frame - Wait out the rest of a frame.
+ * @start: The time the frame started, in nanoseconds.
+ * @fps: The frame rate cap, or 0 (or FPS_VSYNC) for none.
+ **/
+void cap_frame(double start, int fps)
+{
+	struct timespec ts;
+	double left;
+
+	if (fps <= 0)
+		return;
+	left = start + 1e9 / fps - now_ns();
+	if (left <= 0)
+		return;
+	ts.tv_sec = left / 1e9;
+	ts.tv_nsec = left - ts.tv_sec * 1e9;
+	nanosleep(&ts, NULL);
+}
+
+/**
+ * run_sim - Run the simulation headless on every level.
+ * @game: The levels to simulate, from the first one.
+ * @opt: The options: the number of ticks per level.
+ *
+ * Return: 0 on success, 1 if a level cannot be loaded.
+ *
+ * Description: Every level runs the same ticks as the game, chunk
+ * loading and win checks included, along the benchmark's scripted path,
+ * with nothing rendered and no clock: ticks run back to back, as fast as
+ * they can. Reaching the win square does not end a level here.
+ **/
+int run_sim(world *game, options *opt)
+{
+	sim_clock clk;
+	keys key_press;
+	double start, time, total = 0;
+	int lvl, tick, won, next = 0;
+
+	for (lvl = 0; next == 0; lvl++, next = world_advance(game))
+	{
+		world_sync(game);
+		clock_reset(&clk, &game->stage);
+		won = 0;
+		start = now_ns();
+		for (tick = 0; tick < opt->sim; tick++)
+		{
+			script_keys(tick, &key_press);
+			clock_tick(&clk, &game->stage, key_press);
+			grid_load_around(game->stage.map, game->stage.play);
+			check_win(game->stage.play, game->stage.win, &won);
+		}
+		time = now_ns() - start;
+		total += time;
+		printf("level %d: %d ticks in %.3f ms, %.0f ticks/s\n", lvl + 1,
+		       opt->sim, time / 1e6, opt->sim / (time / 1e9));
+	}
+	printf("total:   %d ticks in %.3f ms, %.0f ticks/s\n", opt->sim * lvl,
+	       total / 1e6, opt->sim * lvl / (total / 1e9));
+	return (next < 0);
+}
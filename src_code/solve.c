@@ -0,0 +1,482 @@
+#include "../maze_core.h"
+
+/**
+ * solve_grid_load - Build the bitset of the whole map of a level.
+ * @map: The grid of the level; its loaded chunks are evicted.
+ * @sg: Output for the bitset.
+ *
+ * Return: 0 on success, 1 if the bitset or a chunk cannot be allocated.
+ *
+ * Description: Every chunk is loaded, copied and dropped in turn, as
+ * mazec does, so only the bitset grows with the map: a bit per cell. A
+ * row of a chunk's solidity bitmap is one word of the bitset, inverted.
+ **/
+int solve_grid_load(grid *map, solve_grid *sg)
+{
+	int chunk_rows = (map->height + CHUNK_SIZE - 1) / CHUNK_SIZE, cx, cy, i;
+	const chunk *c;
+
+	sg->words = map->dir_stride - 2;
+	sg->rows = chunk_rows * CHUNK_SIZE + 2;
+	sg->open = calloc(sg->words * sg->rows, sizeof(uint64_t));
+	if (sg->open == NULL)
+		return (1);
+	while (map->count > 0)
+		chunk_evict(map, 0);
+	for (cx = 0; cx < chunk_rows; cx++)
+		for (cy = 0; cy < (int)sg->words; cy++)
+		{
+			if (chunk_load(map, cx, cy) != 0)
+			{
+				free(sg->open);
+				sg->open = NULL;
+				return (1);
+			}
+			c = map->resident[0];
+			for (i = 0; i < CHUNK_SIZE; i++)
+				sg->open[(size_t)(cx * CHUNK_SIZE + i + 1) * sg->words + cy] =
+					~c->solid[i];
+			chunk_evict(map, 0);
+		}
+	return (0);
+}
+
+/**
+ * bfs_spread - Add cells of a word to the next BFS frontier.
+ * @sg: The map.
+ * @seen: The cells reached so far; the new ones are added.
+ * @next: The next frontier; the new cells are added.
+ * @list: The words of the next frontier with a cell in them.
+ * @count: The number of words in @list.
+ * @w: The word.
+ * @bits: The cells of the word a move reaches.
+ *
+ * Return: The number of cells reached for the first time.
+ **/
+static inline long bfs_spread(const solve_grid *sg, uint64_t *seen,
+			      uint64_t *next, size_t *list, size_t *count,
+			      size_t w, uint64_t bits)
+{
+	bits &= sg->open[w] & ~seen[w];
+	if (bits == 0)
+		return (0);
+	if (next[w] == 0)
+		list[(*count)++] = w;
+	next[w] |= bits;
+	seen[w] |= bits;
+	return (__builtin_popcountll(bits));
+}
+
+/**
+ * solve_bfs - Find the shortest path with a bitset frontier BFS.
+ * @sg: The map.
+ * @from: The start cell.
+ * @to: The win cell.
+ * @visited: Output for the number of cells reached.
+ *
+ * Return: The number of moves of the shortest path, SOLVE_NO_PATH if
+ * there is none, or SOLVE_NO_MEMORY.
+ *
+ * Description: The frontier is a bitset, expanded 64 cells at a time:
+ * shifting a word by one reaches the cells beside its own, with a carry
+ * into the words on either side, and the same word one row up or down
+ * reaches the cells above and below. Only the words holding part of the
+ * frontier are listed and expanded, so a step costs as much as the
+ * frontier is long, not as much as the map is large.
+ **/
+long solve_bfs(const solve_grid *sg, int_s from, int_s to, long *visited)
+{
+	size_t words = sg->words, total = sg->words * sg->rows, goal, count = 0;
+	size_t *list, *next_list, *swap_list, next_count, i, w;
+	uint64_t *seen, *front, *next, *swap, goal_bit, f;
+	long steps = SOLVE_NO_PATH, depth;
+
+	*visited = 0;
+	seen = calloc(total, sizeof(uint64_t));
+	front = calloc(total, sizeof(uint64_t));
+	next = calloc(total, sizeof(uint64_t));
+	list = malloc(sizeof(size_t) * total);
+	next_list = malloc(sizeof(size_t) * total);
+	if (seen == NULL || front == NULL || next == NULL || list == NULL ||
+	    next_list == NULL)
+		steps = SOLVE_NO_MEMORY;
+	else
+	{
+		goal = (size_t)(to.x + 1) * words + (to.y >> 6);
+		goal_bit = (uint64_t)1 << (to.y & 63);
+		w = (size_t)(from.x + 1) * words + (from.y >> 6);
+		*visited = bfs_spread(sg, seen, front, list, &count, w,
+				      (uint64_t)1 << (from.y & 63));
+	}
+	for (depth = 0; steps == SOLVE_NO_PATH && count > 0; depth++)
+	{
+		if (seen[goal] & goal_bit)
+		{
+			steps = depth;
+			break;
+		}
+		next_count = 0;
+		for (i = 0; i < count; i++)
+		{
+			w = list[i];
+			f = front[w];
+			front[w] = 0;
+			*visited += bfs_spread(sg, seen, next, next_list, &next_count, w,
+					       (f << 1) | (f >> 1));
+			if ((f >> 63) && w % words != words - 1)
+				*visited += bfs_spread(sg, seen, next, next_list,
+						       &next_count, w + 1, 1);
+			if ((f & 1) && w % words != 0)
+				*visited += bfs_spread(sg, seen, next, next_list,
+						       &next_count, w - 1,
+						       (uint64_t)1 << 63);
+			*visited += bfs_spread(sg, seen, next, next_list, &next_count,
+					       w - words, f);
+			*visited += bfs_spread(sg, seen, next, next_list, &next_count,
+					       w + words, f);
+		}
+		swap = front, front = next, next = swap;
+		swap_list = list, list = next_list, next_list = swap_list;
+		count = next_count;
+	}
+	free(seen);
+	free(front);
+	free(next);
+	free(list);
+	free(next_list);
+	return (steps);
+}
+
+/**
+ * heap_push - Add a node to the A* open list.
+ * @h: The open list.
+ * @node: The node.
+ *
+ * Return: 0 on success, 1 if the list cannot be grown.
+ **/
+int heap_push(solve_heap *h, solve_node node)
+{
+	solve_node *grown;
+	size_t i, parent;
+
+	if (h->count == h->cap)
+	{
+		grown = realloc(h->nodes, sizeof(solve_node) *
+				(h->cap > 0 ? h->cap * 2 : 1024));
+		if (grown == NULL)
+			return (1);
+		h->nodes = grown;
+		h->cap = h->cap > 0 ? h->cap * 2 : 1024;
+	}
+	for (i = h->count++; i > 0; i = parent)
+	{
+		parent = (i - 1) / 2;
+		if (h->nodes[parent].f < node.f ||
+		    (h->nodes[parent].f == node.f && h->nodes[parent].h <= node.h))
+			break;
+		h->nodes[i] = h->nodes[parent];
+	}
+	h->nodes[i] = node;
+	return (0);
+}
+
+/**
+ * heap_pop - Take the best node off the A* open list.
+ * @h: The open list, not empty.
+ *
+ * Return: The node of least f, and of least h among those.
+ **/
+solve_node heap_pop(solve_heap *h)
+{
+	solve_node top = h->nodes[0], last = h->nodes[--h->count];
+	size_t i = 0, child;
+
+	while ((child = 2 * i + 1) < h->count)
+	{
+		if (child + 1 < h->count &&
+		    (h->nodes[child + 1].f < h->nodes[child].f ||
+		     (h->nodes[child + 1].f == h->nodes[child].f &&
+		      h->nodes[child + 1].h < h->nodes[child].h)))
+			child++;
+		if (last.f < h->nodes[child].f ||
+		    (last.f == h->nodes[child].f && last.h <= h->nodes[child].h))
+			break;
+		h->nodes[i] = h->nodes[child];
+		i = child;
+	}
+	h->nodes[i] = last;
+	return (top);
+}
+
+/**
+ * solve_astar - Find the shortest path with A*.
+ * @sg: The map.
+ * @from: The start cell.
+ * @to: The win cell.
+ * @visited: Output for the number of cells expanded.
+ *
+ * Return: The number of moves of the shortest path, SOLVE_NO_PATH if
+ * there is none, or SOLVE_NO_MEMORY.
+ *
+ * Description: The estimate is the Manhattan distance to the win cell,
+ * which a path of moves between adjacent cells can never beat, so the
+ * first path found is a shortest one. Ties go to the node nearest the win
+ * cell, which on open ground heads straight for it. A node whose cell has
+ * been reached by a shorter path since it was added is skipped.
+ **/
+long solve_astar(const solve_grid *sg, int_s from, int_s to, long *visited)
+{
+	size_t width = sg->words * 64, start, goal, cell, near[4];
+	solve_heap open = {NULL, 0, 0};
+	solve_node node;
+	uint32_t *g, cost;
+	long steps = SOLVE_NO_PATH;
+	long x, y;
+	int i;
+
+	*visited = 0;
+	start = (size_t)(from.x + 1) * width + from.y;
+	goal = (size_t)(to.x + 1) * width + to.y;
+	g = malloc(sizeof(uint32_t) * width * sg->rows);
+	if (g == NULL)
+		return (SOLVE_NO_MEMORY);
+	memset(g, 0xFF, sizeof(uint32_t) * width * sg->rows);
+	g[start] = 0;
+	node.h = labs(from.x - (long)to.x) + labs(from.y - (long)to.y);
+	node.f = node.h;
+	node.cell = start;
+	if (!((sg->open[start >> 6] >> (start & 63)) & 1) ||
+	    heap_push(&open, node) != 0)
+		open.count = 0;
+	while (open.count > 0)
+	{
+		node = heap_pop(&open);
+		if (node.f - node.h > g[node.cell])
+			continue;  /* Reached by a shorter path since */
+		(*visited)++;
+		if (node.cell == goal)
+		{
+			steps = g[goal];
+			break;
+		}
+		cell = node.cell;
+		near[0] = cell - width, near[1] = cell + width;
+		near[2] = cell % width > 0 ? cell - 1 : cell;
+		near[3] = cell % width < width - 1 ? cell + 1 : cell;
+		cost = g[cell] + 1;
+		for (i = 0; i < 4; i++)
+		{
+			if (!((sg->open[near[i] >> 6] >> (near[i] & 63)) & 1) ||
+			    g[near[i]] <= cost)
+				continue;
+			g[near[i]] = cost;
+			x = (long)(near[i] / width) - 1;
+			y = (long)(near[i] % width);
+			node.h = labs(x - to.x) + labs(y - to.y);
+			node.f = cost + node.h;
+			node.cell = near[i];
+			if (heap_push(&open, node) != 0)
+			{
+				steps = SOLVE_NO_MEMORY;
+				open.count = 0;
+				break;
+			}
+		}
+	}
+	free(open.nodes);
+	free(g);
+	return (steps);
+}
+
+/**
+ * solve_level - Load a level and solve it with every solver.
+ * @r: The result, with its file set; the rest is filled in.
+ *
+ * Description: Moves are between cells sharing a side, as the player
+ * moves along the x and the y axis separately. The level is dropped once
+ * its bitset is built, so only the bitset and the solvers' own arrays are
+ * held while solving.
+ **/
+void solve_level(solve_result *r)
+{
+	double_s play;
+	solve_grid sg;
+	grid *map;
+	double start = now_ns();
+	int angle, s;
+
+	for (s = 0; s < SOLVERS; s++)
+		r->steps[s] = SOLVE_NO_MEMORY;
+	map = create_map(r->file, &play, &r->win, &angle);
+	if (map == NULL)
+		return;
+	r->width = map->width;
+	r->height = map->height;
+	r->play.x = (int)play.x;
+	r->play.y = (int)play.y;
+	r->loaded = solve_grid_load(map, &sg) == 0;
+	grid_free(map);
+	r->load_ns = now_ns() - start;
+	if (!r->loaded)
+	{
+		fprintf(stderr, "%s: out of memory\n", r->file);
+		return;
+	}
+	for (s = 0; s < SOLVERS; s++)
+	{
+		start = now_ns();
+		if (s == SOLVE_BFS)
+			r->steps[s] = solve_bfs(&sg, r->play, r->win, &r->visited[s]);
+		else
+			r->steps[s] = solve_astar(&sg, r->play, r->win, &r->visited[s]);
+		r->ns[s] = now_ns() - start;
+	}
+	free(sg.open);
+}
+
+/**
+ * solve_range - Solve a range of levels, for the worker pool.
+ * @arg: The results of every level.
+ * @from: The first level to solve.
+ * @to: One past the last level to solve.
+ **/
+void solve_range(void *arg, int from, int to)
+{
+	solve_result *results = arg;
+	int i;
+
+	for (i = from; i < to; i++)
+		solve_level(&results[i]);
+}
+
+/**
+ * solve_report - Print what checking a level found.
+ * @r: The result.
+ *
+ * Return: 0 if the level is solvable, 1 if it is not or could not be
+ * checked.
+ *
+ * Description: The solvers must agree on the length of the path; if they
+ * do not, one of them is wrong and that is reported as a failure too.
+ **/
+int solve_report(const solve_result *r)
+{
+	static const char *const names[SOLVERS] = {"bfs", "astar"};
+	int s, failed = 0;
+
+	if (!r->loaded)
+	{
+		printf("%s: cannot be loaded\n", r->file);
+		return (1);
+	}
+	printf("%s: %dx%d cells, start (%d, %d), win (%d, %d), ", r->file,
+	       r->width, r->height, r->play.x, r->play.y, r->win.x, r->win.y);
+	if (r->steps[SOLVE_BFS] >= 0)
+		printf("solvable in %ld moves", r->steps[SOLVE_BFS]);
+	else if (r->steps[SOLVE_BFS] == SOLVE_NO_PATH)
+		printf("NOT SOLVABLE");
+	else
+		printf("out of memory");
+	printf(", loaded in %.3f ms\n", r->load_ns / 1e6);
+	for (s = 0; s < SOLVERS; s++)
+	{
+		printf("  %-5s %ld moves, %ld cells visited in %.3f ms\n", names[s],
+		       r->steps[s], r->visited[s], r->ns[s] / 1e6);
+		failed |= r->steps[s] != r->steps[SOLVE_BFS] || r->steps[s] < 0;
+	}
+	if (r->steps[SOLVE_ASTAR] != r->steps[SOLVE_BFS])
+		printf("  the solvers disagree\n");
+	return (failed);
+}
+
+/**
+ * cmp_string - Compare two strings for qsort.
+ * @a: Pointer to the first string.
+ * @b: Pointer to the second string.
+ *
+ * Return: Negative, zero or positive as strcmp.
+ **/
+static int cmp_string(const void *a, const void *b)
+{
+	return (strcmp(*(char *const *)a, *(char *const *)b));
+}
+
+/**
+ * level_list - Expand the level paths given on the command line.
+ * @paths: Level files and directories of level files.
+ * @count: The number of paths.
+ * @found: Output for the number of level files.
+ *
+ * Return: The level files, each allocated, or NULL if out of memory.
+ *
+ * Description: A directory stands for every file in it, in name order,
+ * but for hidden ones; it is not searched recursively. Anything else is
+ * taken as a level file, and rejected later if it is not one.
+ **/
+char **level_list(char **paths, int count, int *found)
+{
+	char **files = NULL, **grown, *file;
+	int cap = 0, i, first;
+	struct dirent *entry;
+	struct stat st;
+	DIR *dir;
+
+	*found = 0;
+	for (i = 0; i < count; i++)
+	{
+		dir = stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode) ?
+			opendir(paths[i]) : NULL;
+		first = *found;
+		entry = NULL;
+		do {
+			if (dir != NULL)
+			{
+				entry = readdir(dir);
+				if (entry == NULL)
+					break;
+				if (entry->d_name[0] == '.')
+					continue;
+				file = malloc(strlen(paths[i]) + strlen(entry->d_name) + 2);
+				if (file != NULL)
+					sprintf(file, "%s/%s", paths[i], entry->d_name);
+			}
+			else
+				file = strdup(paths[i]);
+			if (*found == cap)
+			{
+				grown = realloc(files, sizeof(char *) * (cap > 0 ? cap * 2 : 64));
+				if (grown != NULL)
+					files = grown, cap = cap > 0 ? cap * 2 : 64;
+			}
+			if (file == NULL || *found == cap)
+			{
+				free(file);
+				if (dir != NULL)
+					closedir(dir);
+				level_list_free(files, *found);
+				return (NULL);
+			}
+			files[(*found)++] = file;
+		} while (dir != NULL);
+		if (dir != NULL)
+		{
+			closedir(dir);
+			qsort(files + first, *found - first, sizeof(char *), cmp_string);
+		}
+	}
+	return (files);
+}
+
+/**
+ * level_list_free - Free a list of level files.
+ * @files: The list, may be NULL.
+ * @count: The number of files in it.
+ **/
+void level_list_free(char **files, int count)
+{
+	int i;
+
+	for (i = 0; files != NULL && i < count; i++)
+		free(files[i]);
+	free(files);
+}
@@ -0,0 +1,253 @@
+#include "../maze.h"
+
+/**
+ * atlas_load - Load the wall, floor, ceiling and sprite textures.
+ * @dir: The directory of the texture files.
+ *
+ * Return: The textures, or NULL if they cannot be allocated.
+ *
+ * Description: Wall 1-4 textures are read from wall_1.bmp to wall_4.bmp,
+ * the texture of any other wall from wall_other.bmp, the floor and
+ * ceiling from floor.bmp and ceiling.bmp, and the sprites from
+ * sprite_win.bmp, sprite_key.bmp and sprite_enemy.bmp. Each wall texture
+ * gets its E/W shade here, once, rather than darkening every texel drawn.
+ **/
+atlas *atlas_load(const char *dir)
+{
+	static const char *const names[TEX_TYPES] = {
+		"wall_1", "wall_2", "wall_3", "wall_4", "wall_other"
+	};
+	static const char *const sprites[ENTITY_TYPES] = {
+		"sprite_win", "sprite_key", "sprite_enemy"
+	};
+	static const char walls[] = "1234#";
+	atlas *tex;
+	int type;
+
+	tex = malloc(sizeof(atlas));
+	if (tex == NULL)
+		return (NULL);
+	for (type = 0; type < TEX_TYPES; type++)
+	{
+		texture_read(dir, names[type], tex->texels[type * 2],
+			     wall_color(walls[type], 0), 1);
+		texture_shade(tex->texels[type * 2], tex->texels[type * 2 + 1]);
+	}
+	texture_read(dir, "floor", tex->floor, GROUND_COLOR, 0);
+	texture_read(dir, "ceiling", tex->ceiling, SKY_COLOR, 0);
+	for (type = 0; type < ENTITY_TYPES; type++)
+	{
+		sprite_read(dir, sprites[type], tex->sprites[type], type);
+		sprite_spans(tex->sprites[type], tex->opaque[type]);
+	}
+	return (tex);
+}
+
+/**
+ * texture_read - Read a texture, or generate it if it cannot be read.
+ * @dir: The directory of the texture files.
+ * @name: The name of the texture file, without its .bmp suffix.
+ * @texels: Output for the TEX_SIZE * TEX_SIZE texels, column-major.
+ * @base: The color of the texture generated instead.
+ * @stagger: Whether the texture generated instead has staggered bricks.
+ *
+ * Description: A missing file is not an error, so the game runs without
+ * any texture file; one that cannot be read is reported.
+ **/
+void texture_read(const char *dir, const char *name, Uint32 *texels,
+		  Uint32 base, int stagger)
+{
+	char path[512];
+
+	snprintf(path, sizeof(path), "%s/%s.bmp", dir, name);
+	if (access(path, R_OK) != 0 || texture_load(path, texels) != 0)
+		texture_generate(base, stagger, texels);
+}
+
+/**
+ * texture_load - Read a texture from a BMP file.
+ * @path: The path of the file.
+ * @texels: Output for the TEX_SIZE * TEX_SIZE texels, column-major.
+ *
+ * Return: 0 on success, 1 if the file cannot be read; the error has been
+ * reported.
+ *
+ * Description: Any BMP SDL reads will do: it is converted to ARGB8888, then
+ * resampled to TEX_SIZE texels a side (nearest texel) and transposed into
+ * columns. Transparency is ignored, walls are opaque.
+ **/
+int texture_load(const char *path, Uint32 *texels)
+{
+	SDL_Surface *bmp = SDL_LoadBMP(path), *argb = NULL;
+	const Uint32 *src;
+	int u, v;
+
+	if (bmp != NULL)
+		argb = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (argb == NULL || SDL_LockSurface(argb) != 0)
+	{
+		fprintf(stderr, "%s: %s, using a generated texture\n", path,
+			SDL_GetError());
+		SDL_FreeSurface(argb);
+		SDL_FreeSurface(bmp);
+		return (1);
+	}
+	for (v = 0; v < TEX_SIZE; v++)
+	{
+		src = (const Uint32 *)((const Uint8 *)argb->pixels +
+				       (size_t)(v * argb->h / TEX_SIZE) * argb->pitch);
+		for (u = 0; u < TEX_SIZE; u++)
+			texels[u * TEX_SIZE + v] = src[u * argb->w / TEX_SIZE] |
+				0xFF000000;
+	}
+	SDL_UnlockSurface(argb);
+	SDL_FreeSurface(argb);
+	SDL_FreeSurface(bmp);
+	return (0);
+}
+
+/**
+ * texture_generate - Generate a texture of bricks or tiles.
+ * @base: The color of the bricks.
+ * @stagger: 1 to offset every other course by half a brick, 0 for tiles.
+ * @texels: Output for the TEX_SIZE * TEX_SIZE texels, column-major.
+ *
+ * Description: Bricks in a flat color (wall_color for walls), with gray
+ * mortar and a grain of slightly darker texels.
+ **/
+void texture_generate(Uint32 base, int stagger, Uint32 *texels)
+{
+	Uint32 grain;
+	int u, v, offset;
+
+	for (u = 0; u < TEX_SIZE; u++)
+		for (v = 0; v < TEX_SIZE; v++)
+		{
+			offset = stagger * (v / (TEX_SIZE / 4)) % 2 * (TEX_SIZE / 4);
+			grain = ((Uint32)u << 16 | (Uint32)v) * 2654435761u;
+			grain ^= grain >> 15;
+			grain *= 2246822519u;
+			if (v % (TEX_SIZE / 4) == 0 || (u + offset) % (TEX_SIZE / 2) == 0)
+				texels[u * TEX_SIZE + v] = 0xFF8C8C8C;
+			else if (grain >> 31)
+				texels[u * TEX_SIZE + v] = base - ((base >> 3) & 0x1F1F1F);
+			else
+				texels[u * TEX_SIZE + v] = base;
+		}
+}
+
+/**
+ * texture_shade - Make the E/W shade of a texture.
+ * @src: The texels of the N/S face.
+ * @dst: Output for the texels of the E/W face, three quarters as bright.
+ **/
+void texture_shade(const Uint32 *src, Uint32 *dst)
+{
+	int i;
+
+	for (i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+		dst[i] = 0xFF000000 | (((src[i] >> 1) & 0x7F7F7F) +
+				       ((src[i] >> 2) & 0x3F3F3F));
+}
+
+/**
+ * sprite_read - Read a sprite, or generate it if it cannot be read.
+ * @dir: The directory of the texture files.
+ * @name: The name of the texture file, without its .bmp suffix.
+ * @texels: Output for the TEX_SIZE * TEX_SIZE texels, column-major.
+ * @type: The entity type the sprite is generated for instead.
+ *
+ * Description: BMP files have no alpha to speak of, so magenta texels
+ * (0xFF00FF) are the transparent ones.
+ **/
+void sprite_read(const char *dir, const char *name, Uint32 *texels, int type)
+{
+	char path[512];
+	int i;
+
+	snprintf(path, sizeof(path), "%s/%s.bmp", dir, name);
+	if (access(path, R_OK) != 0 || texture_load(path, texels) != 0)
+	{
+		sprite_generate(type, texels);
+		return;
+	}
+	for (i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+		if (texels[i] == 0xFFFF00FF)
+			texels[i] = 0;
+}
+
+/**
+ * sprite_generate - Generate the sprite of an entity type.
+ * @type: The entity type.
+ * @texels: Output for the TEX_SIZE * TEX_SIZE texels, column-major, with
+ * transparent texels zero.
+ *
+ * Description: The win marker is a green diamond floating at eye level, a
+ * key a gold ring and bit lying on the floor, and an enemy a red blob with
+ * two eyes, standing on the floor.
+ **/
+void sprite_generate(int type, Uint32 *texels)
+{
+	int u, v, du, dv, c = TEX_SIZE / 2;
+	Uint32 color;
+
+	for (u = 0; u < TEX_SIZE; u++)
+		for (v = 0; v < TEX_SIZE; v++)
+		{
+			du = u - c;
+			color = 0;
+			if (type == ENTITY_WIN)
+			{
+				dv = abs(v - c);
+				if (abs(du) + dv < c / 2)
+					color = abs(du) + dv < c / 4 ? 0xFF8CFF8C : 0xFF1EB41E;
+			}
+			else if (type == ENTITY_KEY)
+			{
+				dv = v - (TEX_SIZE - c / 2);
+				if (du * du + dv * dv <= 36 && du * du + dv * dv >= 9)
+					color = 0xFFE6B422;  /* Ring */
+				else if (dv >= -2 && dv <= 1 && du > 5 && du < c / 2 + 2)
+					color = 0xFFE6B422;  /* Shaft */
+				else if (dv > 1 && dv <= 4 && (du == c / 2 || du == c / 2 - 3))
+					color = 0xFFB48C1A;  /* Bit */
+			}
+			else
+			{
+				dv = v - (TEX_SIZE - c / 2 - 4);
+				if (du * du + dv * dv <= (c / 2 + 4) * (c / 2 + 4))
+					color = 0xFFB41E1E;
+				du = abs(du) - 6;
+				dv += 6;
+				if (du * du + dv * dv <= 9)
+					color = du * du + dv * dv <= 2 ? 0xFF000000 : 0xFFFFFFFF;
+			}
+			texels[u * TEX_SIZE + v] = color;
+		}
+}
+
+/**
+ * sprite_spans - Find the opaque rows of every column of a sprite.
+ * @texels: The sprite, column-major.
+ * @span: Output for the first opaque row of every column and one past its
+ * last, both 0 for a transparent column.
+ *
+ * Description: Sprites are mostly transparent; drawing only the rows
+ * between the first and last opaque texel of a column skips most of them.
+ **/
+void sprite_spans(const Uint32 *texels, Uint8 (*span)[2])
+{
+	int u, v;
+
+	for (u = 0; u < TEX_SIZE; u++)
+	{
+		span[u][0] = span[u][1] = 0;
+		for (v = 0; v < TEX_SIZE; v++)
+			if (texels[u * TEX_SIZE + v] >> 24)
+			{
+				if (span[u][1] == 0)
+					span[u][0] = v;
+				span[u][1] = v + 1;
+			}
+	}
+}
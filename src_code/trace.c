@@ -0,0 +1,397 @@
+#include "../maze_core.h"
+
+/* Set while tracing: the only cost of a traced scope when it is not */
+int trace_enabled;
+
+static trace_state trace;
+/* The ring of the calling thread, NULL until its first event */
+static _Thread_local trace_ring *own_ring;
+/* Set when the calling thread found no ring left, so it stops looking */
+static _Thread_local int own_dropped;
+
+/**
+ * trace_scope_name - Get the name of a traced scope, as shown in a trace.
+ * @name: The scope, a TRACE_* name.
+ *
+ * Return: The name of the scope.
+ **/
+const char *trace_scope_name(int name)
+{
+	static const char *const names[TRACE_NAMES] = {
+		"frame", "input", "ticks", "movement", "cast", "draw",
+		"draw_background", "draw_walls", "floor", "sprites", "upload",
+		"present", "task"
+	};
+
+	return (name >= 0 && name < TRACE_NAMES ? names[name] : "?");
+}
+
+/**
+ * trace_ring_get - Get the ring of the calling thread.
+ *
+ * Return: The ring, or NULL if all TRACE_THREADS rings are taken or memory
+ * runs out; the events of the thread are then dropped.
+ *
+ * Description: A thread takes a ring at its first event, and is the only
+ * one to write it, so recording takes no lock.
+ **/
+trace_ring *trace_ring_get(void)
+{
+	trace_ring *ring;
+	int slot;
+
+	if (own_ring != NULL || own_dropped)
+		return (own_ring);
+	own_dropped = 1;
+	ring = calloc(1, sizeof(trace_ring));
+	if (ring == NULL)
+		return (NULL);
+	slot = atomic_fetch_add(&trace.threads, 1);
+	if (slot >= TRACE_THREADS)
+	{
+		free(ring);
+		return (NULL);
+	}
+	atomic_init(&ring->head, 0);
+	trace.rings[slot] = ring;
+	own_ring = ring;
+	return (ring);
+}
+
+/**
+ * trace_start - Start tracing.
+ * @prefix: The path of the trace files, without suffix: trace_dump
+ * writes @prefix.json and @prefix.csv.
+ * @budget_ms: The frame time budget; frames over it are flagged as slow.
+ *
+ * Return: 0 on success, 1 if memory runs out.
+ *
+ * Description: The time stamp counter is timed against the clock for a
+ * few ms, to convert it to time. The calling thread takes the first ring,
+ * which the frames are read back from. Start before the worker threads.
+ **/
+int trace_start(const char *prefix, double budget_ms)
+{
+	uint64_t tsc;
+	double ns;
+
+	trace.prefix = prefix;
+	atomic_init(&trace.frame, 0);
+	atomic_init(&trace.threads, 0);
+	trace.slow = 0;
+	if (trace_ring_get() == NULL)
+	{
+		fprintf(stderr, "trace: out of memory\n");
+		return (1);
+	}
+	trace.ns0 = now_ns();
+	trace.tsc0 = trace_clock();
+	do {
+		ns = now_ns();
+		tsc = trace_clock();
+	} while (ns - trace.ns0 < 5e6);
+	trace.ns_per_tick = tsc > trace.tsc0 ? (ns - trace.ns0) /
+		(tsc - trace.tsc0) : 1;
+	trace.budget = budget_ms * 1e6 / trace.ns_per_tick;
+	trace_enabled = 1;
+	return (0);
+}
+
+/**
+ * trace_record - Record a traced scope that has ended.
+ * @name: The scope, a TRACE_* name.
+ * @start: The time stamp counter when it started.
+ * @end: The time stamp counter when it ended.
+ *
+ * Description: The event overwrites the oldest one of the ring of the
+ * thread once it is full. The head is published after the event, for a
+ * dump to read up to it. Presenting, only done by the thread drawing the
+ * frames, is also added up for the frame.
+ **/
+void trace_record(int name, uint64_t start, uint64_t end)
+{
+	trace_ring *ring = trace_ring_get();
+	unsigned long head;
+	trace_event *e;
+
+	if (ring == NULL)
+		return;
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	e = &ring->events[head % TRACE_EVENTS];
+	e->start = start;
+	e->end = end;
+	e->name = name;
+	e->frame = atomic_load_explicit(&trace.frame, memory_order_relaxed);
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+	if (name == TRACE_PRESENT)
+		trace.present += end - start;
+}
+
+/**
+ * trace_frame_begin - Start a traced frame.
+ *
+ * Return: The time it started, to pass to trace_frame_end, or 0 when
+ * tracing is off.
+ *
+ * Description: The events recorded until the next frame, on any thread,
+ * are part of this one.
+ **/
+uint64_t trace_frame_begin(void)
+{
+	if (!trace_enabled)
+		return (0);
+	atomic_fetch_add_explicit(&trace.frame, 1, memory_order_relaxed);
+	trace.present = 0;
+	return (trace_clock());
+}
+
+/**
+ * trace_frame_end - End a traced frame, and flag it if it is slow.
+ * @start: What trace_frame_begin returned.
+ *
+ * Description: The time spent presenting is left out of the time held to
+ * the budget: under vsync it waits for the display, which takes up to a
+ * refresh period, the default budget.
+ **/
+void trace_frame_end(uint64_t start)
+{
+	uint64_t end;
+
+	if (!trace_enabled)
+		return;
+	end = trace_clock();
+	trace_record(TRACE_FRAME, start, end);
+	if (trace_over(end - start, trace.present))
+		trace_slow_frame(start, end);
+}
+
+/**
+ * trace_over - Whether a frame went over the budget.
+ * @ticks: The time the frame took, in time stamp counter ticks.
+ * @present: The time of it spent presenting, which is not counted.
+ *
+ * Return: 1 if the rest is over the budget, 0 if not.
+ **/
+int trace_over(uint64_t ticks, uint64_t present)
+{
+	return (ticks > present && ticks - present > trace.budget);
+}
+
+/**
+ * trace_slow_frame - Report a frame over the budget, and where it went.
+ * @start: The time stamp counter when the frame started.
+ * @end: The time stamp counter when it ended.
+ *
+ * Description: The time of every scope of the frame on the first thread
+ * is added up from its ring, back from the newest event, and printed on
+ * standard error.
+ **/
+void trace_slow_frame(uint64_t start, uint64_t end)
+{
+	const trace_ring *ring = trace.rings[0];
+	unsigned long head = atomic_load(&ring->head), i;
+	uint32_t frame = atomic_load(&trace.frame);
+	double ms[TRACE_NAMES] = {0};
+	const trace_event *e;
+	int name;
+
+	trace.slow++;
+	for (i = head; i > 0 && head - i < TRACE_EVENTS; i--)
+	{
+		e = &ring->events[(i - 1) % TRACE_EVENTS];
+		if (e->frame != frame)
+			break;
+		ms[e->name] += (e->end - e->start) * trace.ns_per_tick / 1e6;
+	}
+	fprintf(stderr, "trace: frame %u took %.2f ms before presenting, over "
+		"%.2f ms:", frame,
+		(end - start - trace.present) * trace.ns_per_tick / 1e6,
+		trace.budget * trace.ns_per_tick / 1e6);
+	for (name = TRACE_FRAME + 1; name < TRACE_NAMES; name++)
+		if (ms[name] > 0)
+			fprintf(stderr, " %s %.2f", trace_scope_name(name), ms[name]);
+	fprintf(stderr, "\n");
+}
+
+/**
+ * trace_dump - Write the events traced so far.
+ *
+ * Return: 0 on success, 1 if a file cannot be written; the error has been
+ * reported.
+ *
+ * Description: The events are written as Chrome trace events to
+ * prefix.json, for chrome://tracing or Perfetto, and as a summary of every
+ * frame to prefix.csv. Tracing goes on; a later dump writes the files
+ * again with the last events. Dump between frames, while the workers are
+ * idle.
+ **/
+int trace_dump(void)
+{
+	char path[PATH_MAX];
+	FILE *out;
+	int i, failed = 0;
+
+	if (!trace_enabled)
+		return (0);
+	for (i = 0; i < 2; i++)
+	{
+		snprintf(path, sizeof(path), "%s.%s", trace.prefix,
+			 i == 0 ? "json" : "csv");
+		out = fopen(path, "w");
+		if (out != NULL)
+		{
+			if (i == 0)
+				trace_json(out);
+			else
+				trace_csv(out);
+		}
+		if (out == NULL || fclose(out) != 0)
+		{
+			perror(path);
+			failed = 1;
+		}
+	}
+	if (!failed)
+		fprintf(stderr, "trace: %d slow frame(s), written to %s.json and "
+			"%s.csv\n", trace.slow, trace.prefix, trace.prefix);
+	return (failed);
+}
+
+/**
+ * trace_json - Write the events traced as Chrome trace events.
+ * @out: The file to write to.
+ *
+ * Description: Every scope is a complete event, in us since tracing
+ * started, on the thread that ran it, with its frame. Slow frames are
+ * marked with an instant event where they ended; the presents of a frame
+ * come before it in the ring, and are left out as by trace_frame_end.
+ **/
+void trace_json(FILE *out)
+{
+	const trace_ring *ring;
+	const trace_event *e;
+	unsigned long head, i;
+	double scale = trace.ns_per_tick / 1e3, ts, dur;
+	uint64_t present = 0;
+	uint32_t frame = 0;
+	int t, threads = atomic_load(&trace.threads);
+
+	if (threads > TRACE_THREADS)
+		threads = TRACE_THREADS;
+	fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (t = 0; t < threads; t++)
+	{
+		fprintf(out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+			"\"tid\": %d, \"args\": {\"name\": \"", t);
+		if (t == 0)
+			fprintf(out, "main");
+		else
+			fprintf(out, "worker %d", t);
+		fprintf(out, "\"}},\n");
+		ring = trace.rings[t];
+		head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		for (i = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0; i < head;
+		     i++)
+		{
+			e = &ring->events[i % TRACE_EVENTS];
+			if (e->frame != frame)
+			{
+				present = 0;
+				frame = e->frame;
+			}
+			if (e->name == TRACE_PRESENT)
+				present += e->end - e->start;
+			ts = (int64_t)(e->start - trace.tsc0) * scale;
+			dur = (e->end - e->start) * scale;
+			fprintf(out, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+				"\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+				"\"args\": {\"frame\": %u}},\n",
+				trace_scope_name(e->name), t, ts, dur, e->frame);
+			if (e->name == TRACE_FRAME &&
+			    trace_over(e->end - e->start, present))
+				fprintf(out, "{\"name\": \"slow frame\", \"ph\": \"i\", "
+					"\"s\": \"g\", \"pid\": 1, \"tid\": %d, "
+					"\"ts\": %.3f, \"args\": {\"frame\": %u}},\n", t,
+					ts + dur, e->frame);
+		}
+	}
+	fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+		"\"args\": {\"name\": \"maze\"}}\n]}\n");
+}
+
+/**
+ * trace_csv - Write a summary of every frame traced.
+ * @out: The file to write to.
+ *
+ * Description: A line per frame still in the ring of the first thread,
+ * with when it started since tracing started, its time, the time of each
+ * scope of the frame on that thread, all in ms, and whether it was over
+ * the budget, presenting left out. The work of the workers is inside the
+ * cast and draw scopes.
+ **/
+void trace_csv(FILE *out)
+{
+	const trace_ring *ring = trace.rings[0];
+	unsigned long head = atomic_load(&ring->head), first, i;
+	double scale = trace.ns_per_tick / 1e6, ms[TRACE_NAMES] = {0};
+	const trace_event *e;
+	uint64_t present = 0;
+	uint32_t frame = 0, partial;
+	int name;
+
+	fprintf(out, "frame,start_ms");
+	for (name = 0; name < TRACE_NAMES; name++)
+		if (name != TRACE_TASK)
+			fprintf(out, ",%s_ms", trace_scope_name(name));
+	fprintf(out, ",slow\n");
+	first = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+	/* The oldest frame of a ring that wrapped lost its first scopes */
+	partial = first > 0 ? ring->events[first % TRACE_EVENTS].frame : 0;
+	for (i = first; i < head; i++)
+	{
+		e = &ring->events[i % TRACE_EVENTS];
+		if (e->frame != frame)
+		{
+			memset(ms, 0, sizeof(ms));
+			present = 0;
+			frame = e->frame;
+		}
+		if (e->name == TRACE_PRESENT)
+			present += e->end - e->start;
+		if (e->name != TRACE_FRAME)
+		{
+			ms[e->name] += (e->end - e->start) * scale;
+			continue;
+		}
+		if (first > 0 && e->frame == partial)
+			continue;
+		fprintf(out, "%u,%.3f", e->frame,
+			(int64_t)(e->start - trace.tsc0) * scale);
+		ms[TRACE_FRAME] = (e->end - e->start) * scale;
+		for (name = 0; name < TRACE_NAMES; name++)
+			if (name != TRACE_TASK)
+				fprintf(out, ",%.3f", ms[name]);
+		fprintf(out, ",%d\n", trace_over(e->end - e->start, present));
+	}
+}
+
+/**
+ * trace_stop - Stop tracing and free the rings.
+ *
+ * Description: Call it once the worker threads have stopped, as their
+ * rings are freed.
+ **/
+void trace_stop(void)
+{
+	int t, threads = atomic_load(&trace.threads);
+
+	if (!trace_enabled)
+		return;
+	trace_enabled = 0;
+	if (threads > TRACE_THREADS)
+		threads = TRACE_THREADS;
+	for (t = 0; t < threads; t++)
+		free(trace.rings[t]);
+	own_ring = NULL;
+	own_dropped = 0;
+}
@@ -0,0 +1,108 @@
+#include "../maze_core.h"
+
+/* cos and sin of every view angle, and camera x of every screen column */
+static double view_cos[ANGLE_STEPS];
+static double view_sin[ANGLE_STEPS];
+static double column_cam[SCREEN_WIDTH];
+static pthread_once_t view_once = PTHREAD_ONCE_INIT;
+
+/**
+ * view_init - Build the angle and camera tables.
+ *
+ * Description: Only the first quadrant is computed with cos; the others
+ * are its exact mirror images, so the four axis-aligned angles are exactly
+ * axis-aligned and no angle drifts. The camera x of a column no longer
+ * needs a division per ray.
+ **/
+void view_init(void)
+{
+	double quarter[ANGLE_STEPS / 4 + 1];
+	double c, s;
+	int i, r;
+
+	for (i = 0; i < ANGLE_STEPS / 4; i++)
+		quarter[i] = cos(2 * M_PI * i / ANGLE_STEPS);
+	quarter[ANGLE_STEPS / 4] = 0;
+	for (i = 0; i < ANGLE_STEPS; i++)
+	{
+		r = i % (ANGLE_STEPS / 4);
+		c = quarter[r];
+		s = quarter[ANGLE_STEPS / 4 - r];
+		switch (i / (ANGLE_STEPS / 4))
+		{
+			case 0:
+				view_cos[i] = c, view_sin[i] = s;
+				break;
+			case 1:
+				view_cos[i] = -s, view_sin[i] = c;
+				break;
+			case 2:
+				view_cos[i] = -c, view_sin[i] = -s;
+				break;
+			default:
+				view_cos[i] = s, view_sin[i] = -c;
+		}
+	}
+	for (i = 0; i < SCREEN_WIDTH; i++)
+		column_cam[i] = 2 * i / (double)SCREEN_WIDTH - 1;
+}
+
+/**
+ * view_vectors - Get the camera vectors of a view angle.
+ * @angle: The view angle, as an index into the angle table.
+ * @dir: Output for the direction vector the player is looking.
+ * @plane: Output for the projection plane vector.
+ *
+ * Description: The plane is the direction turned a quarter to the right
+ * and scaled by VIEW_PLANE, from the same table entries, so the two are
+ * exactly perpendicular at every angle.
+ **/
+void view_vectors(int angle, double_s *dir, double_s *plane)
+{
+	pthread_once(&view_once, view_init);
+	angle &= ANGLE_STEPS - 1;
+	dir->x = view_cos[angle];
+	dir->y = view_sin[angle];
+	plane->x = view_sin[angle] * VIEW_PLANE;
+	plane->y = -view_cos[angle] * VIEW_PLANE;
+}
+
+/**
+ * view_rays - Fill a ray table with the rays of every column of a view.
+ * @rays: The table; left alone when it already holds this angle.
+ * @angle: The view angle.
+ *
+ * Description: The direction and grid deltas of a column only depend on
+ * the view angle, so they are computed once when the player turns and then
+ * looked up by every kernel while walking or standing still. A ray along
+ * one axis gets DELTA_FAR rather than inf for the other one, so that side
+ * distances counted as first + steps * delta stay finite (0 * inf is NaN).
+ **/
+void view_rays(ray_table *rays, int angle)
+{
+	double_s dir, plane;
+	int screen_x;
+
+	angle &= ANGLE_STEPS - 1;
+	if (rays->angle == angle)
+		return;
+	view_vectors(angle, &dir, &plane);
+	for (screen_x = 0; screen_x < SCREEN_WIDTH; screen_x++)
+	{
+		rays->dir_x[screen_x] = dir.x + plane.x * column_cam[screen_x];
+		rays->dir_y[screen_x] = dir.y + plane.y * column_cam[screen_x];
+		rays->del_x[screen_x] = sqrt(1 + (rays->dir_y[screen_x] *
+						  rays->dir_y[screen_x]) /
+					     (rays->dir_x[screen_x] *
+					      rays->dir_x[screen_x]));
+		rays->del_y[screen_x] = sqrt(1 + (rays->dir_x[screen_x] *
+						  rays->dir_x[screen_x]) /
+					     (rays->dir_y[screen_x] *
+					      rays->dir_y[screen_x]));
+		if (!(rays->del_x[screen_x] < DELTA_FAR))
+			rays->del_x[screen_x] = DELTA_FAR;
+		if (!(rays->del_y[screen_x] < DELTA_FAR))
+			rays->del_y[screen_x] = DELTA_FAR;
+	}
+	rays->angle = angle;
+}
@@ -0,0 +1,148 @@
+#include "../maze_core.h"
+
+/**
+ * pool_work - Claim and run chunks of the current job until none are left.
+ * @pool: The pool whose job to work on.
+ *
+ * Description: Chunks are handed out through a shared atomic cursor, so a
+ * thread that finishes its cheap chunks early simply takes the next ones.
+ * Columns whose rays cross long corridors therefore never leave the other
+ * threads idle the way a fixed split of the screen would.
+ **/
+void pool_work(worker_pool *pool)
+{
+	uint64_t start;
+	int from, to;
+
+	while ((from = atomic_fetch_add(&pool->next, pool->grain)) < pool->items)
+	{
+		to = from + pool->grain;
+		if (to > pool->items)
+			to = pool->items;
+		start = trace_begin();
+		pool->fn(pool->ctx, from, to);
+		trace_end(TRACE_TASK, start);
+	}
+}
+
+/**
+ * worker_main - Body of every worker thread of the pool.
+ * @arg: The pool the thread belongs to.
+ *
+ * Return: Always NULL.
+ *
+ * Description: Workers sleep until pool_run publishes a new job, help with
+ * it, and report back once the job has run out of chunks.
+ **/
+void *worker_main(void *arg)
+{
+	worker_pool *pool = arg;
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	while (1)
+	{
+		while (pool->generation == seen && !pool->quit)
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		if (pool->quit)
+			break;
+		seen = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+		pool_work(pool);
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->running == 0)
+			pthread_cond_signal(&pool->idle);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return (NULL);
+}
+
+/**
+ * pool_run - Run a job over a range of items on every thread of the pool.
+ * @pool: The pool to run the job on, or NULL to run it on the caller only.
+ * @fn: The function called for every chunk of items.
+ * @ctx: The context passed to fn.
+ * @items: The number of items in the job.
+ * @grain: The number of items in a chunk.
+ *
+ * Description: The calling thread works on the job too and only returns
+ * once every chunk is done and no worker still touches the job.
+ **/
+void pool_run(worker_pool *pool, pool_fn fn, void *ctx, int items, int grain)
+{
+	if (pool == NULL || pool->count == 0)
+	{
+		fn(ctx, 0, items);
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pool->fn = fn;
+	pool->ctx = ctx;
+	pool->items = items;
+	pool->grain = grain;
+	atomic_store(&pool->next, 0);
+	pool->running = pool->count;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	pool_work(pool);
+	pthread_mutex_lock(&pool->lock);
+	while (pool->running > 0)
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * pool_create - Start a persistent pool of worker threads.
+ * @threads: The total number of threads to work with, caller included.
+ *
+ * Return: The pool, or NULL on failure.
+ **/
+worker_pool *pool_create(int threads)
+{
+	worker_pool *pool;
+
+	pool = calloc(1, sizeof(worker_pool));
+	if (pool == NULL)
+		return (NULL);
+	pool->threads = malloc(sizeof(pthread_t) * (threads > 1 ? threads - 1 : 1));
+	if (pool->threads == NULL)
+	{
+		free(pool);
+		return (NULL);
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+	atomic_init(&pool->next, 0);
+	for (pool->count = 0; pool->count < threads - 1; pool->count++)
+	{
+		if (pthread_create(&pool->threads[pool->count], NULL, worker_main,
+				   pool) != 0)
+			break;
+	}
+	return (pool);
+}
+
+/**
+ * pool_destroy - Stop the worker threads and free the pool.
+ * @pool: The pool to destroy, may be NULL.
+ **/
+void pool_destroy(worker_pool *pool)
+{
+	int i;
+
+	if (pool == NULL)
+		return;
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->count; i++)
+		pthread_join(pool->threads[i], NULL);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->idle);
+	free(pool->threads);
+	free(pool);
+}